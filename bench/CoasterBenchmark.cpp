@@ -0,0 +1,61 @@
+/**
+ * File:	CoasterBenchmark.cpp
+ *
+ * Summary:
+ *
+ * Headless throughput of CoasterSimulation: many independent trains on the
+ * viewer's default track (lift to the highest point, brakes on the last
+ * tenth), stepped at 1 kHz. Reports train steps and completed rides (laps)
+ * per second of wall clock time.
+ *
+ * Usage: ./CoasterBenchmark [numTrains] [simulatedSeconds]
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+#include "ArcLengthTable.h"
+#include "CoasterPhysics.h"
+#include "TrackFile.h"
+
+typedef std::chrono::high_resolution_clock Clock;
+
+int main(int argc, char **argv) {
+  int numTrains = (argc > 1) ? std::atoi(argv[1]) : 4096;
+  float seconds = (argc > 2) ? float(std::atof(argv[2])) : 60.f;
+  const float dt = 1.f / 1000.f;
+
+  ArcLengthTable track(defaultTrackControlPoints());
+
+  CoasterSimulation sim;
+  sim.setTrack(track);
+
+  float length = sim.trackLength();
+  CoasterParameters parameters = defaultCoasterParameters(sim);
+  sim.setParameters(parameters);
+
+  // spread over the track so every kind of section is in every step
+  for (int i = 0; i < numTrains; ++i)
+    sim.addTrain(i * length / numTrains, parameters.chainSpeed);
+
+  long long numSteps = static_cast<long long>(seconds / dt);
+  Clock::time_point start = Clock::now();
+  for (long long i = 0; i < numSteps; ++i)
+    sim.step(dt);
+  double elapsed =
+      std::chrono::duration<double>(Clock::now() - start).count();
+
+  long long rides = 0;
+  for (int i = 0; i < numTrains; ++i)
+    rides += sim.laps(i);
+
+  std::cout << "trains: " << numTrains << " simulated: " << seconds
+            << " s at " << 1.f / dt << " Hz" << std::endl;
+  std::cout << "wall clock   : " << elapsed << " s" << std::endl;
+  std::cout << "train steps/s: " << numTrains * numSteps / elapsed
+            << std::endl;
+  std::cout << "rides/s      : " << rides / elapsed << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,172 @@
+/**
+ * File:	Mat4fBenchmark.cpp
+ *
+ * Summary:
+ *
+ * Compares the inline storage Mat4f against the previous heap allocated
+ * implementation (a std::unique_ptr< std::array<float,16> > per matrix,
+ * reproduced below as LegacyMat4f).
+ *
+ * Each test builds model matrices the way a scene does every frame
+ * (translate * rotate * scale) and multiplies them into a view projection.
+ *
+ * Usage: ./Mat4fBenchmark [numMatrices] [numRepetitions]
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "Mat4f.h"
+#include "OpenGLMatrixTools.h"
+
+// ====== PREVIOUS IMPLEMENTATION ===========================================//
+class LegacyMat4f {
+public:
+  enum { DIM = 4, NUM_ELEM = 16 };
+
+  typedef std::array<float, NUM_ELEM> ARRAY_16f;
+  typedef std::unique_ptr<ARRAY_16f> Mat4fHandle;
+
+  LegacyMat4f() : m_ptr(new ARRAY_16f) {}
+
+  LegacyMat4f(std::initializer_list<float> list) : m_ptr(new ARRAY_16f) {
+    std::copy_n(list.begin(), NUM_ELEM, m_ptr->begin());
+  }
+
+  LegacyMat4f(LegacyMat4f &&moved) : m_ptr(std::move(moved.m_ptr)) {}
+
+  LegacyMat4f(const LegacyMat4f &copied) : m_ptr(new ARRAY_16f) {
+    std::copy_n(copied.m_ptr->begin(), NUM_ELEM, m_ptr->begin());
+  }
+
+  LegacyMat4f &operator=(LegacyMat4f &&moved) {
+    m_ptr = std::move(moved.m_ptr);
+    return *this;
+  }
+
+  float &operator()(int row, int column) {
+    return m_ptr->at(row * DIM + column);
+  }
+
+  float operator()(int row, int column) const {
+    return m_ptr->at(row * DIM + column);
+  }
+
+  LegacyMat4f operator*(const LegacyMat4f &other) const {
+    LegacyMat4f result;
+
+    float element;
+    for (int i = 0; i < DIM; ++i) {
+      for (int j = 0; j < DIM; ++j) {
+        element = 0;
+        for (int k = 0; k < DIM; ++k) {
+          element += (*this)(i, k) * other(k, j);
+        }
+        result(i, j) = element;
+      }
+    }
+
+    return result;
+  }
+
+  float *data() { return m_ptr->data(); }
+  float const *data() const { return m_ptr->data(); }
+
+private:
+  Mat4fHandle m_ptr;
+};
+
+LegacyMat4f LegacyTranslateMatrix(float x, float y, float z) {
+  LegacyMat4f trans = {1, 0, 0, x, 0, 1, 0, y, 0, 0, 1, z, 0, 0, 0, 1};
+  return trans;
+}
+
+LegacyMat4f LegacyRotateAboutYMatrix(float angleDeg) {
+  float angleRad = angleDeg * (M_PI / 180.0);
+  float c = std::cos(angleRad);
+  float s = std::sin(angleRad);
+  LegacyMat4f rot = {c, 0, s, 0, 0, 1, 0, 0, -s, 0, c, 0, 0, 0, 0, 1};
+  return rot;
+}
+
+LegacyMat4f LegacyUniformScaleMatrix(float scale) {
+  LegacyMat4f uniform = {scale, 0, 0, 0, 0, scale, 0, 0,
+                         0,     0, scale, 0, 0, 0, 0, 1};
+  return uniform;
+}
+// ==========================================================================//
+
+typedef std::chrono::high_resolution_clock Clock;
+
+double nanosecondsSince(Clock::time_point start) {
+  return std::chrono::duration<double, std::nano>(Clock::now() - start)
+      .count();
+}
+
+template <typename MAT>
+float checksum(std::vector<MAT> const &mats) {
+  float sum = 0.f;
+  for (auto const &m : mats)
+    sum += m.data()[3] + m.data()[10];
+  return sum;
+}
+
+int main(int argc, char **argv) {
+  int numMatrices = (argc > 1) ? std::atoi(argv[1]) : 10000;
+  int numReps = (argc > 2) ? std::atoi(argv[2]) : 50;
+
+  std::vector<Mat4f> current;
+  std::vector<LegacyMat4f> legacy;
+  current.reserve(numMatrices);
+  legacy.reserve(numMatrices);
+
+  Mat4f VP = PerspectiveProjection(60, 4.f / 3.f, 0.01, 1000) *
+             LookAtMatrix(Vec3f(0, 0, 5), Vec3f(0, 0, 0), Vec3f(0, 1, 0));
+  LegacyMat4f legacyVP;
+  std::copy_n(VP.data(), 16, legacyVP.data());
+
+  double bestCurrent = 1e300;
+  double bestLegacy = 1e300;
+  float sumCurrent = 0.f;
+  float sumLegacy = 0.f;
+
+  for (int rep = 0; rep < numReps; ++rep) {
+    current.clear();
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < numMatrices; ++i) {
+      float f = float(i);
+      current.push_back(VP * TranslateMatrix(f, 0.5f * f, -f) *
+                        RotateAboutYMatrix(f) * UniformScaleMatrix(0.3f));
+    }
+    bestCurrent = std::min(bestCurrent, nanosecondsSince(start));
+    sumCurrent = checksum(current);
+
+    legacy.clear();
+    start = Clock::now();
+    for (int i = 0; i < numMatrices; ++i) {
+      float f = float(i);
+      legacy.push_back(legacyVP * LegacyTranslateMatrix(f, 0.5f * f, -f) *
+                       LegacyRotateAboutYMatrix(f) *
+                       LegacyUniformScaleMatrix(0.3f));
+    }
+    bestLegacy = std::min(bestLegacy, nanosecondsSince(start));
+    sumLegacy = checksum(legacy);
+  }
+
+  std::cout << "matrices per rep: " << numMatrices << " reps: " << numReps
+            << std::endl;
+  std::cout << "inline Mat4f : " << bestCurrent / numMatrices
+            << " ns/model matrix" << std::endl;
+  std::cout << "legacy Mat4f : " << bestLegacy / numMatrices
+            << " ns/model matrix" << std::endl;
+  std::cout << "speedup      : " << bestLegacy / bestCurrent << "x"
+            << std::endl;
+  std::cout << "checksums    : " << sumCurrent << " " << sumLegacy
+            << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,435 @@
+/**
+ * File:	MicroBenchmarks.cpp
+ *
+ * Summary:
+ *
+ * Times the hot math, curve and mesh kernels one call at a time.
+ *
+ * Every benchmark is calibrated first: the number of calls per sample is
+ * doubled until one sample takes at least --sample-us microseconds, so
+ * timer resolution does not matter even for nanosecond operations. Then
+ * --warmup samples are run and thrown away (caches, branch predictors,
+ * frequency scaling), and --samples samples are recorded. Reported times are
+ * per call: minimum, median, mean and 99th percentile of the samples.
+ *
+ * Inputs cycle through small precomputed tables, and every result goes
+ * through doNotOptimize(), so the compiler can neither fold calls into
+ * constants nor drop them.
+ *
+ * Usage: ./MicroBenchmarks [--json file] [--label text] [--filter text]
+ *                          [--samples n] [--warmup n] [--sample-us n]
+ *
+ * --json writes the results as JSON (see writeJson()) for comparing runs,
+ * --label is stored with them (e.g. a git revision), --filter only runs
+ * the benchmarks whose name contains the text.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "BezierCurve.h"
+#include "CurveTessellator.h"
+#include "EditableTrack.h"
+#include "Mat4f.h"
+#include "MeshGenerator.h"
+#include "Quat4f.h"
+#include "TrackFile.h"
+#include "Vec3f.h"
+#include "Vec3f_FileIO.h"
+
+typedef std::chrono::steady_clock Clock;
+
+// ====== HARNESS ===========================================================//
+
+// Keeps value (and everything needed to compute it) alive
+template <typename T> inline void doNotOptimize(T const &value) {
+#if defined(__GNUC__) || defined(__clang__)
+  asm volatile("" : : "r,m"(value) : "memory");
+#else
+  static volatile char const *sink;
+  sink = reinterpret_cast<char const *>(&value);
+#endif
+}
+
+struct BenchmarkOptions {
+  BenchmarkOptions() : warmupSamples(10), samples(101), minSampleNs(50000) {}
+
+  int warmupSamples;
+  int samples;
+  double minSampleNs;
+  std::string filter;
+};
+
+struct BenchmarkResult {
+  std::string name;
+  long long callsPerSample;
+  int samples;
+  double minNs; // all per call
+  double medianNs;
+  double meanNs;
+  double p99Ns;
+};
+
+// Nearest rank percentile of sorted values, p in [0,100]
+double percentile(std::vector<double> const &sorted, double p) {
+  std::size_t rank =
+      static_cast<std::size_t>(std::ceil(p / 100.0 * sorted.size()));
+  return sorted[std::min(std::max(rank, std::size_t(1)), sorted.size()) - 1];
+}
+
+template <typename Function>
+double timeCalls(Function &function, long long calls) {
+  Clock::time_point start = Clock::now();
+  for (long long i = 0; i < calls; ++i)
+    function(i);
+  return std::chrono::duration<double, std::nano>(Clock::now() - start)
+      .count();
+}
+
+// function(i) performs call number i
+template <typename Function>
+BenchmarkResult runBenchmark(std::string const &name, Function function,
+                             BenchmarkOptions const &options) {
+  long long calls = 1;
+  while (timeCalls(function, calls) < options.minSampleNs && calls < (1 << 30))
+    calls *= 2;
+
+  for (int i = 0; i < options.warmupSamples; ++i)
+    timeCalls(function, calls);
+
+  std::vector<double> perCall(options.samples);
+  for (int i = 0; i < options.samples; ++i)
+    perCall[i] = timeCalls(function, calls) / calls;
+  std::sort(perCall.begin(), perCall.end());
+
+  BenchmarkResult result;
+  result.name = name;
+  result.callsPerSample = calls;
+  result.samples = options.samples;
+  result.minNs = perCall.front();
+  result.medianNs = percentile(perCall, 50.0);
+  result.p99Ns = percentile(perCall, 99.0);
+  double sum = 0.0;
+  for (double t : perCall)
+    sum += t;
+  result.meanNs = sum / perCall.size();
+  return result;
+}
+
+class BenchmarkSuite {
+public:
+  explicit BenchmarkSuite(BenchmarkOptions const &options)
+      : m_options(options) {}
+
+  template <typename Function>
+  void add(std::string const &name, Function function) {
+    if (!m_options.filter.empty() &&
+        name.find(m_options.filter) == std::string::npos)
+      return;
+
+    BenchmarkResult result = runBenchmark(name, function, m_options);
+    std::cout << std::left << std::setw(34) << name << std::right
+              << " median " << std::setw(12) << result.medianNs << " ns"
+              << "   p99 " << std::setw(12) << result.p99Ns << " ns"
+              << std::endl;
+    m_results.push_back(result);
+  }
+
+  std::vector<BenchmarkResult> const &results() const { return m_results; }
+  BenchmarkOptions const &options() const { return m_options; }
+
+private:
+  BenchmarkOptions m_options;
+  std::vector<BenchmarkResult> m_results;
+};
+
+std::string jsonEscape(std::string const &text) {
+  std::string out;
+  for (char c : text) {
+    if (c == '"' || c == '\\') {
+      out += '\\';
+      out += c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      char code[8];
+      std::snprintf(code, sizeof(code), "\\u%04x", c);
+      out += code;
+    } else {
+      out += c;
+    }
+  }
+  return out;
+}
+
+// {
+//   "suite": "MicroBenchmarks", "label": ..., "timestamp": ..., "compiler": ...,
+//   "warmup_samples": n, "samples": n, "min_sample_ns": n,
+//   "benchmarks": [ { "name": ..., "calls_per_sample": n, "samples": n,
+//                     "min_ns": x, "median_ns": x, "mean_ns": x,
+//                     "p99_ns": x }, ... ]
+// }
+bool writeJson(std::string const &fileName, BenchmarkSuite const &suite,
+               std::string const &label) {
+  std::ofstream out(fileName);
+  if (!out)
+    return false;
+
+  std::time_t now = std::time(nullptr);
+  char timestamp[32];
+  std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ",
+                std::gmtime(&now));
+
+#if defined(__VERSION__)
+  std::string compiler = __VERSION__;
+#else
+  std::string compiler = "unknown";
+#endif
+
+  BenchmarkOptions const &options = suite.options();
+  out << std::setprecision(9);
+  out << "{\n";
+  out << "  \"suite\": \"MicroBenchmarks\",\n";
+  out << "  \"label\": \"" << jsonEscape(label) << "\",\n";
+  out << "  \"timestamp\": \"" << timestamp << "\",\n";
+  out << "  \"compiler\": \"" << jsonEscape(compiler) << "\",\n";
+  out << "  \"warmup_samples\": " << options.warmupSamples << ",\n";
+  out << "  \"samples\": " << options.samples << ",\n";
+  out << "  \"min_sample_ns\": " << options.minSampleNs << ",\n";
+  out << "  \"benchmarks\": [";
+
+  std::vector<BenchmarkResult> const &results = suite.results();
+  for (std::size_t i = 0; i < results.size(); ++i) {
+    BenchmarkResult const &r = results[i];
+    out << (i == 0 ? "\n" : ",\n");
+    out << "    {\"name\": \"" << jsonEscape(r.name) << "\", "
+        << "\"calls_per_sample\": " << r.callsPerSample << ", "
+        << "\"samples\": " << r.samples << ", "
+        << "\"min_ns\": " << r.minNs << ", "
+        << "\"median_ns\": " << r.medianNs << ", "
+        << "\"mean_ns\": " << r.meanNs << ", "
+        << "\"p99_ns\": " << r.p99Ns << "}";
+  }
+  out << "\n  ]\n}\n";
+
+  return bool(out);
+}
+
+// ====== INPUTS ============================================================//
+
+enum { NUM_INPUTS = 64 }; // power of two, cycled with i & (NUM_INPUTS - 1)
+
+float randomFloat(float low, float high) {
+  return low + (high - low) * (std::rand() / float(RAND_MAX));
+}
+
+Vec3f randomVec3f() {
+  return Vec3f(randomFloat(-1, 1), randomFloat(-1, 1), randomFloat(-1, 1));
+}
+
+glm::vec3 randomVec3() {
+  return glm::vec3(randomFloat(-5, 5), randomFloat(-5, 5), randomFloat(-5, 5));
+}
+
+Quat4f randomUnitQuat() {
+  return Quat4f(randomFloat(-1, 1), randomVec3f()).normalized();
+}
+
+Mat4f randomMat4f() {
+  Mat4f m;
+  for (float &f : m)
+    f = randomFloat(-1, 1);
+  return m;
+}
+
+// Control point file of numLines "x y z" lines, like test.txt
+std::string writeControlPointFile(int numLines) {
+  std::string fileName = "MicroBenchmarks_points.txt";
+  std::ofstream out(fileName);
+  out << "# generated by MicroBenchmarks\n";
+  for (int i = 0; i < numLines; ++i) {
+    glm::vec3 p = randomVec3();
+    out << p.x << " " << p.y << " " << p.z << "\n";
+  }
+  return fileName;
+}
+
+// ====== MAIN ==============================================================//
+
+int main(int argc, char **argv) {
+  BenchmarkOptions options;
+  std::string jsonFile;
+  std::string label;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (arg == "--json" && hasValue)
+      jsonFile = argv[++i];
+    else if (arg == "--label" && hasValue)
+      label = argv[++i];
+    else if (arg == "--filter" && hasValue)
+      options.filter = argv[++i];
+    else if (arg == "--samples" && hasValue)
+      options.samples = std::max(1, std::atoi(argv[++i]));
+    else if (arg == "--warmup" && hasValue)
+      options.warmupSamples = std::max(0, std::atoi(argv[++i]));
+    else if (arg == "--sample-us" && hasValue)
+      options.minSampleNs = 1000.0 * std::atof(argv[++i]);
+    else {
+      std::cerr << "Usage: " << argv[0]
+                << " [--json file] [--label text] [--filter text]"
+                   " [--samples n] [--warmup n] [--sample-us n]"
+                << std::endl;
+      return 1;
+    }
+  }
+
+  std::srand(587);
+  const int mask = NUM_INPUTS - 1;
+
+  std::vector<Mat4f> mats;
+  std::vector<Quat4f> quats;
+  std::vector<Vec3f> vecs;
+  std::vector<glm::vec3> points;
+  std::vector<float> params;
+  for (int i = 0; i < NUM_INPUTS; ++i) {
+    mats.push_back(randomMat4f());
+    quats.push_back(randomUnitQuat());
+    vecs.push_back(randomVec3f());
+    points.push_back(randomVec3());
+    params.push_back(randomFloat(0, 1));
+  }
+
+  BenchmarkSuite suite(options);
+
+  // ===== Mat4f ===== //
+  suite.add("Mat4f::operator*", [&](long long i) {
+    Mat4f m = mats[i & mask] * mats[(i + 1) & mask];
+    doNotOptimize(m);
+  });
+
+  suite.add("Mat4f::transposed", [&](long long i) {
+    Mat4f m = mats[i & mask].transposed();
+    doNotOptimize(m);
+  });
+
+  // ===== Quat4f ===== //
+  suite.add("Quat4f::operator*", [&](long long i) {
+    Quat4f q = quats[i & mask] * quats[(i + 1) & mask];
+    doNotOptimize(q);
+  });
+
+  suite.add("Quat4f slerp", [&](long long i) {
+    Quat4f q = slerp(quats[i & mask], quats[(i + 1) & mask], params[i & mask]);
+    doNotOptimize(q);
+  });
+
+  suite.add("Quat4f::matrix4f", [&](long long i) {
+    Mat4f m = quats[i & mask].matrix4f();
+    doNotOptimize(m);
+  });
+
+  // ===== Vec3f ===== //
+  suite.add("Vec3f::slerp", [&](long long i) {
+    Vec3f v = Vec3f::slerp(params[i & mask], vecs[i & mask],
+                           vecs[(i + 1) & mask]);
+    doNotOptimize(v);
+  });
+
+  suite.add("rotateAround", [&](long long i) {
+    Vec3f const &vec = vecs[i & mask]; // const: the returning overload
+    Vec3f v = rotateAround(vec, vecs[(i + 1) & mask],
+                           params[i & mask] * 6.2831853f);
+    doNotOptimize(v);
+  });
+
+  // ===== Curves ===== //
+  suite.add("calcPoint", [&](long long i) {
+    glm::vec3 p = calcPoint(points[i & mask], points[(i + 1) & mask],
+                            points[(i + 2) & mask], points[(i + 3) & mask],
+                            params[i & mask]);
+    doNotOptimize(p);
+  });
+
+  // the curve the viewer builds when it loads the default track
+  // (loadCurve, now loadLineGeometryToGPU): g_track's 16 vertices per
+  // segment and no arc length table
+  std::vector<glm::vec3> track = defaultTrackControlPoints();
+  EditableTrack drawnTrack(16, 0);
+  suite.add("loadCurve (EditableTrack::reset, default track)",
+            [&](long long) {
+              drawnTrack.reset(track);
+              doNotOptimize(drawnTrack.vertices().data());
+            });
+
+  // the same track adaptively tessellated to a 0.002 tolerance
+  std::vector<glm::vec3> curve;
+  suite.add("tessellateCurveAdaptive (default track)", [&](long long) {
+    tessellateCurveAdaptive(track, 0.002f, curve);
+    doNotOptimize(curve.data());
+  });
+
+  // dragging one control point of a long track: its segments are drawn and
+  // measured again, the arc lengths after them shifted
+  std::vector<glm::vec3> longTrack(3 * 50000 + 1);
+  for (std::size_t i = 0; i < longTrack.size(); ++i)
+    longTrack[i] = glm::vec3(i * 0.5f, 0.f, 0.f) + randomVec3();
+  EditableTrack editableTrack;
+  editableTrack.reset(longTrack);
+  suite.add("EditableTrack::update (50k segments)", [&](long long i) {
+    std::size_t index = (i * 7919) % longTrack.size();
+    editableTrack.setControlPoint(index,
+                                  longTrack[index] + 0.01f * points[i & mask]);
+    editableTrack.update();
+    doNotOptimize(editableTrack.arcLengthTable().lengths().data());
+  });
+
+  // orienting a car: a search in the arc length table and a slerp
+  ArcLengthTable const &longTable = editableTrack.arcLengthTable();
+  suite.add("RotationMinimizingFrames::orientationAt", [&](long long i) {
+    float s = params[i & mask] * longTable.totalLength();
+    Quat4f q = editableTrack.frames().orientationAt(longTable.sampleAt(s));
+    doNotOptimize(q);
+  });
+
+  // ===== Meshes ===== //
+  IndexedMesh sphere;
+  suite.add("getSpherePoints (triangles)", [&](long long) {
+    getSpherePoints(0.3f, glm::vec3(0, 0, 0), sphere, MESH_TRIANGLES);
+    doNotOptimize(sphere.indices.data());
+  });
+
+  suite.add("getSpherePoints (strips)", [&](long long) {
+    getSpherePoints(0.3f, glm::vec3(0, 0, 0), sphere, MESH_TRIANGLE_STRIPS);
+    doNotOptimize(sphere.indices.data());
+  });
+
+  // ===== File I/O ===== //
+  std::string pointFile = writeControlPointFile(10000);
+  VectorContainerVec3f loaded;
+  suite.add("loadVec3fFromFile (10k lines)", [&](long long) {
+    loadVec3fFromFile(loaded, pointFile);
+    doNotOptimize(loaded.data());
+  });
+  std::remove(pointFile.c_str());
+
+  if (!jsonFile.empty()) {
+    if (!writeJson(jsonFile, suite, label)) {
+      std::cerr << "Unable to write " << jsonFile << std::endl;
+      return 1;
+    }
+    std::cout << "results written to " << jsonFile << std::endl;
+  }
+
+  return 0;
+}
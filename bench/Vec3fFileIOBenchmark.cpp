@@ -0,0 +1,147 @@
+/**
+ * File:	Vec3fFileIOBenchmark.cpp
+ *
+ * Summary:
+ *
+ * Throughput (MB/s) of loadVec3fFromFile against the previous getline /
+ * stringstream parser (reproduced below as legacyLoadVec3fFromFile).
+ *
+ * Writes a generated control point file (with comments, blank lines and the
+ * odd bad line) first, then loads it several times with each parser.
+ *
+ * Usage: ./Vec3fFileIOBenchmark [numLines] [numRepetitions] [file]
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+#include "Vec3f_FileIO.h"
+
+// ====== PREVIOUS IMPLEMENTATION ===========================================//
+void legacyLoadVec3fFromFile(VectorContainerVec3f &vecs,
+                             std::string const &fileName) {
+  using std::string;
+  using std::stringstream;
+
+  std::ifstream file(fileName);
+
+  if (!file) {
+    throw std::runtime_error("Unable to open file.");
+  }
+
+  string line;
+  size_t index;
+  stringstream ss(std::ios_base::in);
+
+  size_t lineNum = 0;
+  vecs.clear();
+
+  while (getline(file, line)) {
+    ++lineNum;
+
+    index = line.find_first_of("#");
+    if (index != string::npos) {
+      line.erase(index, string::npos);
+    }
+
+    line.erase(0, line.find_first_not_of(" \t\r\n\v\f"));
+    index = line.find_last_not_of(" \t\r\n\v\f") + 1;
+    if (index != string::npos) {
+      line.erase(index, string::npos);
+    }
+
+    if (line.empty()) {
+      continue;
+    }
+
+    ss.str(line);
+    ss.clear();
+
+    try {
+      Vec3f v;
+      ss >> v;
+
+      if (!ss) {
+        throw std::runtime_error("Error read file: " + line + " (line: " +
+                                 std::to_string(lineNum) + ")");
+      } else {
+        vecs.push_back(v);
+      }
+    } catch (const std::exception &e) {
+      // the original printed e.what() here
+    }
+  }
+  file.close();
+}
+// ==========================================================================//
+
+typedef std::chrono::high_resolution_clock Clock;
+
+double secondsSince(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+std::size_t writeTrackFile(std::string const &fileName, int numLines) {
+  std::ofstream file(fileName);
+  file << "# generated track\n";
+  for (int i = 0; i < numLines; ++i) {
+    if (i % 1000 == 0)
+      file << "\n   # section " << i << "\n";
+    if (i % 10007 == 0)
+      file << "bad line\n";
+
+    float t = i * 0.001f;
+    file << -0.094377f * t << " " << 0.246226f + t << " " << -t * t
+         << (i % 3 == 0 ? "  # note\n" : "\n");
+  }
+  file.flush();
+  return static_cast<std::size_t>(file.tellp());
+}
+
+int main(int argc, char **argv) {
+  int numLines = (argc > 1) ? std::atoi(argv[1]) : 1000000;
+  int numReps = (argc > 2) ? std::atoi(argv[2]) : 5;
+  std::string fileName = (argc > 3) ? argv[3] : "Vec3fFileIOBenchmark.txt";
+
+  double megabytes = writeTrackFile(fileName, numLines) / (1024.0 * 1024.0);
+
+  VectorContainerVec3f current, legacy;
+  Vec3fFileStatus status;
+  double bestCurrent = 1e300;
+  double bestLegacy = 1e300;
+
+  for (int rep = 0; rep < numReps; ++rep) {
+    Clock::time_point start = Clock::now();
+    status = loadVec3fFromFile(current, fileName);
+    bestCurrent = std::min(bestCurrent, secondsSince(start));
+
+    start = Clock::now();
+    legacyLoadVec3fFromFile(legacy, fileName);
+    bestLegacy = std::min(bestLegacy, secondsSince(start));
+  }
+
+  std::remove(fileName.c_str());
+
+  std::cout << "file: " << megabytes << " MB, " << status.numLines
+            << " lines, " << current.size() << " points, "
+            << status.numErrors << " bad lines" << std::endl;
+  std::cout << "from_chars parser  : " << megabytes / bestCurrent << " MB/s"
+            << std::endl;
+  std::cout << "stringstream parser: " << megabytes / bestLegacy << " MB/s"
+            << std::endl;
+  std::cout << "speedup            : " << bestLegacy / bestCurrent << "x"
+            << std::endl;
+
+  if (current.size() != legacy.size() ||
+      !std::equal(current.begin(), current.end(), legacy.begin())) {
+    std::cout << "MISMATCH between parsers" << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,127 @@
+/**
+ * File:	ArcLengthTable.h
+ *
+ * Summary:
+ *
+ * Cumulative arc length table of a piecewise cubic Bezier curve.
+ *
+ * Each segment is sampled at a fixed number of parameter values, and the
+ * running chord length is stored alongside the (segment, t) of each sample.
+ * Looking up a distance s is a binary search for the bracketing samples and
+ * a linear interpolation of t between them, the position is then evaluated
+ * on the Bezier segment itself, so objects move at (close to) constant speed
+ * along the real curve rather than along the tessellation.
+ *
+ * When s only increases (an animation), pass an ArcLengthCursor along with
+ * each lookup: the search then starts from the last result and is O(1)
+ * amortized instead of O(log n).
+ *
+ * Lengths are kept per segment (from the segment's start) next to the
+ * running total at each segment start, so after moving a few control points
+ * update() measures only the segments they belong to and shifts the totals
+ * after them, instead of measuring the whole track again.
+ */
+
+#ifndef ARC_LENGTH_TABLE_H
+#define ARC_LENGTH_TABLE_H
+
+#include <cstddef>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// Location on a curve: segment index and parameter t in [0,1]
+struct CurveParameter {
+  int segment;
+  float t;
+};
+
+// Between samples index and index + 1, fraction of the way, at arc length
+// distance. For tables kept per sample next to an ArcLengthTable (see
+// RotationMinimizingFrames.h), which then need no search of their own.
+struct ArcLengthSample {
+  std::size_t index;
+  float fraction;
+  float distance;
+};
+
+// Remembers the sample interval of the previous lookup
+struct ArcLengthCursor {
+  ArcLengthCursor() : index(0) {}
+  std::size_t index;
+};
+
+class ArcLengthTable {
+public:
+  enum { DEFAULT_SAMPLES_PER_SEGMENT = 64 };
+
+public:
+  ArcLengthTable();
+  explicit ArcLengthTable(std::vector<glm::vec3> const &controlPoints,
+                          int samplesPerSegment = DEFAULT_SAMPLES_PER_SEGMENT);
+
+  void build(std::vector<glm::vec3> const &controlPoints,
+             int samplesPerSegment = DEFAULT_SAMPLES_PER_SEGMENT);
+
+  // Adopts lengths computed earlier by build() with the same control points
+  // and samplesPerSegment (e.g. stored in a track file). Returns false, and
+  // leaves the table empty, when numLengths does not match.
+  bool assign(std::vector<glm::vec3> const &controlPoints,
+              int samplesPerSegment, float const *lengths,
+              std::size_t numLengths);
+  void clear();
+
+  // Measures the listed segments again (sorted, no duplicates), e.g. after
+  // their control points moved, and shifts the lengths of every segment
+  // after the first of them. controlPoints must have the number of points
+  // the table was built with, otherwise nothing changes and false is
+  // returned. Gives the same table as build().
+  bool update(std::vector<glm::vec3> const &controlPoints,
+              std::vector<int> const &segments);
+
+  bool empty() const;
+  std::size_t size() const; // number of samples
+  int numSegments() const;
+  int samplesPerSegment() const;
+  float totalLength() const;
+  float segmentStart(int segment) const; // arc length where segment begins
+
+  // s is clamped to [0, totalLength()]
+  CurveParameter parameterAt(float s) const;
+  CurveParameter parameterAt(float s, ArcLengthCursor &cursor) const;
+
+  glm::vec3 positionAt(float s) const;
+  glm::vec3 positionAt(float s, ArcLengthCursor &cursor) const;
+
+  // Only valid for a table that is not empty
+  ArcLengthSample sampleAt(float s) const;
+  ArcLengthSample sampleAt(float s, ArcLengthCursor &cursor) const;
+  CurveParameter sampleParameter(std::size_t sample) const;
+
+  // Points cursor at s with a binary search, so a walk can start anywhere
+  void seek(float s, ArcLengthCursor &cursor) const;
+
+  // s wrapped into [0, totalLength()), for closed tracks
+  float wrap(float s) const;
+
+  std::vector<float> const &lengths() const;
+  std::vector<glm::vec3> const &controlPoints() const;
+
+private:
+  void measureSegment(int segment, int samplesPerSegment);
+  void accumulate(int firstSegment);
+  std::size_t findInterval(float s) const;
+  std::size_t findInterval(float s, ArcLengthCursor &cursor) const;
+  CurveParameter interpolate(std::size_t interval, float s) const;
+  ArcLengthSample sample(std::size_t interval, float s) const;
+
+private:
+  std::vector<glm::vec3> m_controlPoints;
+  std::vector<float> m_lengths; // cumulative length at each sample
+  std::vector<float> m_localLengths;   // length from the segment start
+  std::vector<double> m_segmentStarts; // length before each segment
+  std::vector<int> m_segments;  // segment of each sample
+  std::vector<float> m_params;  // t of each sample
+};
+
+#endif // ARC_LENGTH_TABLE_H
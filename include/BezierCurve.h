@@ -0,0 +1,39 @@
+/**
+ * File:	BezierCurve.h
+ *
+ * Summary:
+ *
+ * Piecewise cubic Bezier curve helpers. A curve with n segments is stored as
+ * 3n+1 control points, segment i uses points 3i, 3i+1, 3i+2 and 3i+3.
+ */
+
+#ifndef BEZIER_CURVE_H
+#define BEZIER_CURVE_H
+
+#include <cstddef>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+glm::vec3 lerp(glm::vec3 a, glm::vec3 b, float t);
+
+// de Casteljau evaluation of the cubic a, b, c, d at t in [0,1]
+glm::vec3 calcPoint(glm::vec3 a, glm::vec3 b, glm::vec3 c, glm::vec3 d,
+                    float t);
+
+// Derivative dP/dt of the cubic a, b, c, d at t in [0,1]
+glm::vec3 calcDerivative(glm::vec3 a, glm::vec3 b, glm::vec3 c, glm::vec3 d,
+                         float t);
+
+// Number of complete cubic segments in a list of control points
+int numBezierSegments(std::size_t numControlPoints);
+
+// Point on segment `segment` at parameter t in [0,1]
+glm::vec3 calcSegmentPoint(std::vector<glm::vec3> const &controlPoints,
+                           int segment, float t);
+
+// Derivative of segment `segment` at parameter t in [0,1]
+glm::vec3 calcSegmentDerivative(std::vector<glm::vec3> const &controlPoints,
+                                int segment, float t);
+
+#endif // BEZIER_CURVE_H
@@ -34,6 +34,22 @@ public:
 
   mat4 lookatMatrix() const;
 
+  // Ride along: the view of a rider at position with orientation, a unit
+  // quaternion (x, y, z, w) turning -z forward and +y up into world space
+  // (see RotationMinimizingFrames.h), eyeHeight above it. Set every frame.
+  void setRidePose(vec3 const &position, vec4 const &orientation);
+  void setEyeHeight(float eyeHeight);
+
+  // Blends into (or back out of) the ride over blendSeconds
+  void startRide(float blendSeconds);
+  void stopRide(float blendSeconds);
+  void update(float seconds); // advances the blend
+  bool riding() const;        // the ride is (partly) in view
+  float rideWeight() const;   // 0 free-fly, 1 riding
+
+  // lookatMatrix(), the ride, or in between while blending
+  mat4 viewMatrix() const;
+
   void move(vec3 const &offset);
 
   float focusDistance() const;
@@ -48,5 +64,12 @@ private:
   vec3 m_up;
   vec3 m_forward;
   vec3 rotateAround(vec3 const &vec, vec3 const &axis, float radians);
+
+  vec3 m_ridePosition;
+  vec4 m_rideOrientation;
+  float m_eyeHeight;
+  float m_rideBlend;  // 0 to 1, eased into rideWeight()
+  float m_rideTarget; // where m_rideBlend is heading
+  float m_blendSeconds;
 };
 #endif /* defined(____Camera__) */
@@ -0,0 +1,93 @@
+/**
+ * File:	CurveTessellator.h
+ *
+ * Summary:
+ *
+ * Turns piecewise cubic Bezier control points (see BezierCurve.h) into line
+ * strip vertices.
+ *
+ * Each segment is converted to its power basis coefficients once,
+ *   P(t) = a t^3 + b t^2 + c t + d
+ * and then stepped with forward differences, which costs 9 additions per
+ * sample instead of the 6 lerps of calcPoint(). The differences restart on
+ * every segment so round off cannot build up along the whole track.
+ *
+ * Output goes into a caller sized buffer, tessellatedSize() gives the number
+ * of vertices needed. Every segment gets the same number of vertices, so
+ * after an edit tessellateCurveSegments() can redo just the segments whose
+ * control points moved, in place.
+ *
+ * tessellateCurveAdaptive() instead splits each segment in half (de
+ * Casteljau at t = 0.5) until its control polygon lies within a chordal
+ * error tolerance of the chord, so straight stretches get few vertices and
+ * tight bends get many.
+ */
+
+#ifndef CURVE_TESSELLATOR_H
+#define CURVE_TESSELLATOR_H
+
+#include <cstddef>
+#include <iostream>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// P(t) = a t^3 + b t^2 + c t + d
+struct CubicCoefficients {
+  glm::vec3 a, b, c, d;
+};
+
+CubicCoefficients bezierCoefficients(glm::vec3 const &p0, glm::vec3 const &p1,
+                                     glm::vec3 const &p2, glm::vec3 const &p3);
+
+// samplesPerSegment points per segment (t = 0, 1/n, ..., (n-1)/n) plus the
+// final control point, so consecutive segments never repeat a vertex.
+std::size_t tessellatedSize(std::size_t numControlPoints,
+                            int samplesPerSegment);
+
+// out must hold tessellatedSize(numControlPoints, samplesPerSegment) points.
+// Returns the number of points written.
+std::size_t tessellateCurve(glm::vec3 const *controlPoints,
+                            std::size_t numControlPoints,
+                            int samplesPerSegment, glm::vec3 *out);
+
+// Resizes out and tessellates into it
+void tessellateCurve(std::vector<glm::vec3> const &controlPoints,
+                     int samplesPerSegment, std::vector<glm::vec3> &out);
+
+// Rewrites only the vertices of the listed segments in out, which holds the
+// tessellateCurve() output of the same number of control points (segment i
+// owns vertices [i * samplesPerSegment, (i + 1) * samplesPerSegment), the
+// final vertex is rewritten with the last segment). Gives the same vertices
+// as tessellating the whole curve again.
+void tessellateCurveSegments(glm::vec3 const *controlPoints,
+                             std::size_t numControlPoints,
+                             int samplesPerSegment, int const *segments,
+                             std::size_t numSegments, glm::vec3 *out);
+
+struct TessellationStats {
+  TessellationStats();
+
+  std::size_t numVertices;
+  std::size_t numLines;
+  int maxDepth;     // deepest subdivision reached
+  int numForced;    // pieces emitted at maxDepth without meeting tolerance
+  float maxError;   // largest chordal error bound of an emitted line
+  float meanError;  // average chordal error bound over all lines
+};
+
+std::ostream &operator<<(std::ostream &out, TessellationStats const &stats);
+
+// Distance bound between a cubic and its chord p0-p3: the largest distance
+// of the inner control points from the chord (convex hull property).
+float chordalError(glm::vec3 const &p0, glm::vec3 const &p1,
+                   glm::vec3 const &p2, glm::vec3 const &p3);
+
+// Clears out, then appends the vertices of every segment, subdivided until
+// chordalError() <= tolerance or maxDepth is reached.
+TessellationStats
+tessellateCurveAdaptive(std::vector<glm::vec3> const &controlPoints,
+                        float tolerance, std::vector<glm::vec3> &out,
+                        int maxDepth = 16);
+
+#endif // CURVE_TESSELLATOR_H
@@ -0,0 +1,107 @@
+/**
+ * File:	EditableTrack.h
+ *
+ * Summary:
+ *
+ * A track whose control points are edited while it is shown and ridden.
+ *
+ * The control points are kept apart from what is derived from them: the
+ * line strip vertices it is drawn with (tessellateCurve()), its arc length
+ * table and the rotation minimizing frames at the table's samples. Moving a
+ * control point only marks the segments that use it as dirty, update() then
+ * re-tessellates and re-measures just those segments, so dragging a point on
+ * a track of tens of thousands of segments costs a few segments of work plus
+ * shifting the arc lengths after them.
+ *
+ * Every segment has the same number of vertices, so an edit never moves the
+ * vertices of other segments: updatedVertices() lists the runs of vertices
+ * the last update() rewrote, which is all a GPU copy of vertices() needs to
+ * be sent again (e.g. with glBufferSubData). The number of segments only
+ * changes through reset().
+ *
+ * Either half may be left out (0 samples), e.g. a viewer that draws the
+ * track while another thread rides it can keep one EditableTrack with only
+ * vertices and one with only the arc length table and frames, and hand the
+ * edits from one to the other as TrackEdits.
+ */
+
+#ifndef EDITABLE_TRACK_H
+#define EDITABLE_TRACK_H
+
+#include <cstddef>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "ArcLengthTable.h"
+#include "RotationMinimizingFrames.h"
+
+// Control point index moved to position
+struct TrackEdit {
+  std::size_t index;
+  glm::vec3 position;
+};
+
+// Vertices [first, first + count) of EditableTrack::vertices()
+struct VertexRange {
+  std::size_t first;
+  std::size_t count;
+};
+
+class EditableTrack {
+public:
+  // tessellationSamples vertices per segment to draw with, and
+  // arcLengthSamples arc length samples (and frames) per segment; 0 for
+  // none
+  explicit EditableTrack(
+      int tessellationSamples = 16,
+      int arcLengthSamples = ArcLengthTable::DEFAULT_SAMPLES_PER_SEGMENT);
+
+  // Replaces the whole track, nothing is dirty afterwards
+  void reset(std::vector<glm::vec3> const &controlPoints);
+  // As reset(controlPoints), but adopts a table measured earlier (e.g. read
+  // from a track file) when it has arcLengthSamples per segment
+  void reset(std::vector<glm::vec3> const &controlPoints,
+             ArcLengthTable const &table);
+
+  int numSegments() const;
+  std::vector<glm::vec3> const &controlPoints() const;
+  std::vector<glm::vec3> const &vertices() const;
+  ArcLengthTable const &arcLengthTable() const;
+  RotationMinimizingFrames const &frames() const;
+
+  void setControlPoint(std::size_t index, glm::vec3 const &position);
+  void apply(std::vector<TrackEdit> const &edits);
+  bool dirty() const;
+
+  // Re-tessellates and re-measures the dirty segments, returns false if
+  // there were none
+  bool update();
+
+  // What the last update() changed: the segments (sorted) and the runs of
+  // vertices. The arc lengths from arcLengthTable().segmentStart() of the
+  // first segment on have changed.
+  std::vector<int> const &updatedSegments() const;
+  std::vector<VertexRange> const &updatedVertices() const;
+
+private:
+  void assignControlPoints(std::vector<glm::vec3> const &controlPoints);
+  void markDirty(int segment);
+
+private:
+  int m_tessellationSamples;
+  int m_arcLengthSamples;
+
+  std::vector<glm::vec3> m_controlPoints;
+  std::vector<glm::vec3> m_vertices;
+  ArcLengthTable m_arcLengthTable;
+  RotationMinimizingFrames m_frames;
+
+  std::vector<char> m_isDirty; // per segment
+  std::vector<int> m_dirtySegments;
+
+  std::vector<int> m_updatedSegments;
+  std::vector<VertexRange> m_updatedVertices;
+};
+
+#endif // EDITABLE_TRACK_H
@@ -0,0 +1,83 @@
+/**
+ * File:	FixedStepScheduler.h
+ *
+ * Summary:
+ *
+ * Runs a simulation at a fixed time step, independent of the render rate.
+ *
+ * Each frame the real time that passed is added to an accumulator, and the
+ * simulation is stepped while a whole step fits into it. What is left over
+ * (alpha() of a step) is how far the display is between the previous and the
+ * current simulation state, so rendering interpolates the two instead of
+ * showing the state with up to one step of jitter.
+ *
+ * A frame that takes very long (a breakpoint, a window drag, a slow load)
+ * would otherwise ask for more steps than can run in one frame, making the
+ * next frame slower still. At most maxStepsPerUpdate steps run per update;
+ * time beyond that is dropped (the simulation runs slow rather than the
+ * application freezing) and counted in droppedTime().
+ *
+ * timeScale() > 1 runs more simulated time per real second, e.g. to fast
+ * forward a ride, < 1 is slow motion.
+ */
+
+#ifndef FIXED_STEP_SCHEDULER_H
+#define FIXED_STEP_SCHEDULER_H
+
+class FixedStepScheduler {
+public:
+  enum { DEFAULT_MAX_STEPS_PER_UPDATE = 250 };
+
+public:
+  explicit FixedStepScheduler(
+      double stepSeconds = 1.0 / 1000.0,
+      int maxStepsPerUpdate = DEFAULT_MAX_STEPS_PER_UPDATE);
+
+  // Adds realSeconds (scaled by timeScale()) and returns the number of
+  // steps due, already taken into account by time() and stepCount().
+  int advance(double realSeconds);
+
+  // advance(), then step(time, stepSeconds) once per due step, time being
+  // the simulation time at the end of that step
+  template <typename StepFunction>
+  int update(double realSeconds, StepFunction step);
+
+  void reset();
+
+  double stepSeconds() const;
+  void setStepSeconds(double seconds);
+
+  int maxStepsPerUpdate() const;
+  void setMaxStepsPerUpdate(int steps);
+
+  double timeScale() const;
+  void setTimeScale(double scale);
+
+  double time() const; // simulation time of the current state
+  long long stepCount() const;
+  double droppedTime() const; // simulated seconds skipped by the cap
+
+  // Fraction of a step from the previous to the current state, in [0,1)
+  float alpha() const;
+
+private:
+  double m_stepSeconds;
+  int m_maxStepsPerUpdate;
+  double m_timeScale;
+
+  double m_accumulator;
+  double m_time;
+  long long m_stepCount;
+  double m_droppedTime;
+};
+
+template <typename StepFunction>
+int FixedStepScheduler::update(double realSeconds, StepFunction step) {
+  int steps = advance(realSeconds);
+  double t = m_time - (steps - 1) * m_stepSeconds;
+  for (int i = 0; i < steps; ++i, t += m_stepSeconds)
+    step(t, m_stepSeconds);
+  return steps;
+}
+
+#endif // FIXED_STEP_SCHEDULER_H
@@ -0,0 +1,126 @@
+/**
+ * File:	FrameCapture.h
+ *
+ * Summary:
+ *
+ * Rendering without a visible window, and getting the frames back to the
+ * CPU without waiting for them.
+ *
+ * OffscreenTarget is a framebuffer object of a fixed size to draw into
+ * instead of the window, optionally multisampled (and then resolved into a
+ * single sampled one to read from).
+ *
+ * FrameReadback copies frames out through a ring of pixel buffer objects.
+ * glReadPixels into a bound GL_PIXEL_PACK_BUFFER only queues the copy, so
+ * capture() returns at once; a frame's pixels are mapped and handed to the
+ * sink numBuffers - 1 frames later, when its slot is needed again and the
+ * copy (checked with a fence) has long finished. Only if the GPU is that
+ * far behind does mapping wait, counted by stalls().
+ *
+ *   target.bind();
+ *   draw();
+ *   readback.capture(target, sink); // sink gets an earlier frame, if any
+ *   ...
+ *   readback.finish(sink);          // the frames still in flight
+ *
+ * Pixels are handed over as tightly packed RGB rows, bottom row first (as
+ * OpenGL reads them). writePPM() writes them as a binary PPM image.
+ *
+ * Both delete their GL objects in destroy() and their destructors, with the
+ * context current.
+ */
+
+#ifndef FRAME_CAPTURE_H
+#define FRAME_CAPTURE_H
+
+#include "glad/glad.h"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+class OffscreenTarget {
+public:
+  OffscreenTarget();
+  ~OffscreenTarget();
+
+  OffscreenTarget(const OffscreenTarget &) = delete;
+  OffscreenTarget &operator=(const OffscreenTarget &) = delete;
+
+  // Color and depth of width x height, samples > 1 for multisampling.
+  // Returns false (and stays invalid) if the framebuffer is incomplete.
+  bool create(int width, int height, int samples = 0);
+  void destroy();
+
+  bool isValid() const;
+  int width() const;
+  int height() const;
+
+  // Draws go into the target, with the viewport covering it
+  void bind() const;
+
+  // Resolves the samples (if any) and returns the framebuffer to read from
+  GLuint resolve() const;
+
+private:
+  GLuint m_drawFramebuffer;
+  GLuint m_readFramebuffer; // same as m_drawFramebuffer if not multisampled
+  std::vector<GLuint> m_renderbuffers;
+  int m_width;
+  int m_height;
+  int m_samples;
+};
+
+class FrameReadback {
+public:
+  // frame counts capture() calls from 0
+  typedef std::function<void(long long frame, unsigned char const *rgb,
+                             int width, int height)>
+      FrameSink;
+
+  enum { DEFAULT_NUM_BUFFERS = 3 };
+
+public:
+  explicit FrameReadback(int numBuffers = DEFAULT_NUM_BUFFERS);
+  ~FrameReadback();
+
+  FrameReadback(const FrameReadback &) = delete;
+  FrameReadback &operator=(const FrameReadback &) = delete;
+
+  bool create(int width, int height);
+  void destroy();
+
+  // Queues the copy of framebuffer's color, first passing the frame whose
+  // slot it takes to sink
+  void capture(GLuint framebuffer, FrameSink const &sink);
+  void capture(OffscreenTarget const &target, FrameSink const &sink);
+
+  // Every frame still in flight, oldest first
+  void finish(FrameSink const &sink);
+
+  long long numCaptured() const;
+  long long stalls() const; // copies not finished when they were needed
+
+private:
+  struct Slot {
+    GLuint buffer;
+    GLsync fence;
+    long long frame; // -1 when empty
+  };
+
+  void collect(Slot &slot, FrameSink const &sink);
+
+private:
+  std::vector<Slot> m_slots;
+  std::size_t m_next;
+  int m_width;
+  int m_height;
+  long long m_numCaptured;
+  long long m_stalls;
+};
+
+// Binary PPM (P6) of RGB rows stored bottom row first
+bool writePPM(std::string const &fileName, unsigned char const *rgb,
+              int width, int height);
+
+#endif // FRAME_CAPTURE_H
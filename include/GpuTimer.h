@@ -0,0 +1,104 @@
+/**
+ * File:	GpuTimer.h
+ *
+ * Summary:
+ *
+ * GPU time of sections of a frame, measured with GL_TIME_ELAPSED queries
+ * and recorded into a Profiler (see Profiler.h).
+ *
+ * A query's result is only there once the GPU has caught up with it, and
+ * asking for it before that waits for the GPU. So the queries of a frame
+ * are kept in a ring of frameLatency frames and only read when their slot
+ * comes round again, frameLatency frames later, by which time they are
+ * normally done. One that still is not is dropped (counted by dropped())
+ * rather than waited for; reading never stalls the pipeline.
+ *
+ *   timer.beginFrame();           // once per frame, after
+ *                                 // Profiler::nextFrame()
+ *   {
+ *     GpuScope scope(timer, DRAW_GPU);
+ *     draw();
+ *   }
+ *
+ * The first frame measured is left out: it includes the driver's lazy set
+ * up, and some drivers (Mesa llvmpipe) report a meaningless time for the
+ * first query.
+ *
+ * GL_TIME_ELAPSED queries cannot nest: sections must follow one another, a
+ * begin() while another section is open is ignored.
+ *
+ * Query objects are made as needed and reused, destroy() deletes them and
+ * needs the context to be current.
+ */
+
+#ifndef GPU_TIMER_H
+#define GPU_TIMER_H
+
+#include "glad/glad.h"
+
+#include <vector>
+
+#include "Profiler.h"
+
+class GpuTimer {
+public:
+  enum { DEFAULT_FRAME_LATENCY = 4 };
+
+public:
+  explicit GpuTimer(Profiler &profiler,
+                    int frameLatency = DEFAULT_FRAME_LATENCY);
+
+  GpuTimer(const GpuTimer &) = delete;
+  GpuTimer &operator=(const GpuTimer &) = delete;
+
+  // Records what the queries of frameLatency frames ago measured, and
+  // starts the profiler's current frame
+  void beginFrame();
+
+  // false if another section is open
+  bool begin(int section);
+  void end();
+
+  unsigned long long dropped() const;
+
+  void destroy();
+
+private:
+  struct Query {
+    GLuint id;
+    int section;
+  };
+
+  struct Frame {
+    unsigned long long number;
+    std::vector<GLuint> pool; // query objects of this slot
+    std::vector<Query> issued;
+  };
+
+  void collect(Frame &frame);
+
+private:
+  Profiler &m_profiler;
+  std::vector<Frame> m_frames;
+  std::size_t m_current;
+  bool m_started; // a frame has begun
+  unsigned long long m_firstFrame;
+  bool m_open;
+  unsigned long long m_dropped;
+};
+
+// A GpuTimer section from construction to destruction
+class GpuScope {
+public:
+  GpuScope(GpuTimer &timer, int section);
+  ~GpuScope();
+
+  GpuScope(const GpuScope &) = delete;
+  GpuScope &operator=(const GpuScope &) = delete;
+
+private:
+  GpuTimer &m_timer;
+  bool m_began;
+};
+
+#endif // GPU_TIMER_H
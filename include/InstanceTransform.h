@@ -0,0 +1,44 @@
+/**
+ * File:	InstanceTransform.h
+ *
+ * Summary:
+ *
+ * Per-instance data of instanced_vs.glsl. Each instance is placed by a
+ * position, a uniform scale and an orientation quaternion, 32 bytes instead
+ * of a 64 byte model matrix, and the vertex shader builds the transform.
+ *
+ * Attribute layout (divisor 1):
+ *   location 1 : vec4 positionScale
+ *   location 2 : vec4 orientation
+ */
+
+#ifndef INSTANCE_TRANSFORM_H
+#define INSTANCE_TRANSFORM_H
+
+#include <glm/glm.hpp>
+
+struct InstanceTransform {
+  InstanceTransform()
+      : positionScale(0.f, 0.f, 0.f, 1.f), orientation(0.f, 0.f, 0.f, 1.f) {}
+
+  glm::vec4 positionScale; // xyz position, w uniform scale
+  glm::vec4 orientation;   // unit quaternion (x, y, z, w), w is real
+};
+
+// Between two simulation states: position and scale linearly, orientation
+// by normalized lerp along the shorter arc (close enough to slerp for the
+// small rotations of one time step).
+inline InstanceTransform interpolate(InstanceTransform const &a,
+                                     InstanceTransform const &b, float alpha) {
+  InstanceTransform result;
+  result.positionScale = glm::mix(a.positionScale, b.positionScale, alpha);
+
+  glm::vec4 target =
+      (glm::dot(a.orientation, b.orientation) < 0.f) ? -b.orientation
+                                                     : b.orientation;
+  result.orientation =
+      glm::normalize(glm::mix(a.orientation, target, alpha));
+  return result;
+}
+
+#endif // INSTANCE_TRANSFORM_H
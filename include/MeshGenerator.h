@@ -0,0 +1,66 @@
+/**
+ * File:	MeshGenerator.h
+ *
+ * Summary:
+ *
+ * Indexed mesh generation. Every vertex is stored once and triangles refer
+ * to it through a 16 bit index buffer, ready for glDrawElements with
+ * GL_UNSIGNED_SHORT.
+ *
+ * Surfaces of revolution (the sphere is one) take the sine and cosine of
+ * each latitude and longitude once, from tables filled by incremental
+ * rotation, so filling the vertices is only multiplies and adds.
+ *
+ * Strip meshes draw one GL_TRIANGLE_STRIP per latitude band, separated by
+ * MESH_RESTART_INDEX, so they need
+ *   glEnable(GL_PRIMITIVE_RESTART);
+ *   glPrimitiveRestartIndex(MESH_RESTART_INDEX);
+ */
+
+#ifndef MESH_GENERATOR_H
+#define MESH_GENERATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+const std::uint16_t MESH_RESTART_INDEX = 0xFFFF;
+
+enum MeshTopology { MESH_TRIANGLES, MESH_TRIANGLE_STRIPS };
+
+struct IndexedMesh {
+  IndexedMesh();
+  void clear();
+
+  MeshTopology topology;
+  std::vector<glm::vec3> vertices;
+  std::vector<glm::vec2> texCoords;
+  std::vector<std::uint16_t> indices;
+};
+
+// sines[k] = sin(start + k * step), cosines[k] = cos(start + k * step) for
+// k in [0, count). Each entry is the previous one rotated by step (one
+// complex multiply in double precision) instead of a sin/cos call.
+void sinCosTable(double startRadians, double stepRadians, int count,
+                 std::vector<float> &sines, std::vector<float> &cosines);
+
+// Revolves a profile curve about the y axis. Each profile point is
+// (distance from the axis, height), and is swept through 360 degrees in
+// `slices` steps. Profile points on the axis (distance 0) are poles, their
+// degenerate triangles are left out.
+// Returns false (and leaves mesh empty) if the mesh would need more
+// vertices than a 16 bit index can address.
+bool getSurfaceOfRevolution(std::vector<glm::vec2> const &profile, int slices,
+                            glm::vec3 center, IndexedMesh &mesh,
+                            MeshTopology topology = MESH_TRIANGLES);
+
+// UV sphere with a vertex every stepDegrees of latitude and longitude.
+// Returns false (and leaves mesh empty) if the sphere would need more
+// vertices than a 16 bit index can address.
+bool getSpherePoints(float radius, glm::vec3 center, IndexedMesh &mesh,
+                     MeshTopology topology = MESH_TRIANGLES,
+                     int stepDegrees = 5);
+
+#endif // MESH_GENERATOR_H
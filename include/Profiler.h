@@ -0,0 +1,115 @@
+/**
+ * File:	Profiler.h
+ *
+ * Summary:
+ *
+ * Where each frame's milliseconds go: named sections, each keeping the
+ * durations of its last windowSize runs.
+ *
+ * CPU time is taken with a ProfileScope, which times its own lifetime:
+ *
+ *   int const DRAW = profiler.section("draw"); // once, e.g. at start up
+ *   ...
+ *   {
+ *     ProfileScope scope(profiler, DRAW);
+ *     draw();
+ *   }
+ *
+ * GPU time comes in through record() from whoever measured it, in the
+ * viewer a GpuTimer (see GpuTimer.h), some frames after the fact, so it is
+ * recorded against the frame it was measured in.
+ *
+ * report() prints the mean, median, 95th and 99th percentile and maximum of
+ * every section over its window. With a CSV file open every duration is
+ * also written as a "frame,section,milliseconds" row, frames being counted
+ * by nextFrame().
+ *
+ * Sections may be recorded from any thread (e.g. the simulation thread's
+ * steps), recording takes a mutex that is held for a few stores.
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <iosfwd>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct ProfileStats {
+  std::string name;
+  std::size_t count; // durations in the window
+  double meanMs;
+  double medianMs;
+  double p95Ms;
+  double p99Ms;
+  double maxMs;
+};
+
+class Profiler {
+public:
+  enum { DEFAULT_WINDOW_SIZE = 240 };
+
+public:
+  explicit Profiler(std::size_t windowSize = DEFAULT_WINDOW_SIZE);
+
+  Profiler(const Profiler &) = delete;
+  Profiler &operator=(const Profiler &) = delete;
+
+  // Id of the section called name, added on first use
+  int section(std::string const &name);
+
+  // A duration of section, in the current frame or in frame
+  void record(int section, double milliseconds);
+  void record(int section, double milliseconds, unsigned long long frame);
+
+  void nextFrame();
+  unsigned long long frame() const;
+
+  // Rows of every duration recorded from now on, false if fileName could
+  // not be opened
+  bool openCsv(std::string const &fileName);
+  void closeCsv();
+
+  // Sections in the order they were added, those never recorded included
+  std::vector<ProfileStats> stats() const;
+  void report(std::ostream &out) const;
+
+  void reset(); // forgets the durations, keeps the sections
+
+private:
+  struct Section {
+    std::string name;
+    std::vector<double> window; // ring of the last durations
+    std::size_t next;           // where the next one goes
+    std::size_t count;          // valid entries of window
+  };
+
+private:
+  std::size_t m_windowSize;
+  std::vector<Section> m_sections;
+  std::atomic<unsigned long long> m_frame;
+  std::ofstream m_csv;
+  mutable std::mutex m_mutex;
+};
+
+// Records the time from its construction to its destruction
+class ProfileScope {
+public:
+  ProfileScope(Profiler &profiler, int section);
+  ~ProfileScope();
+
+  ProfileScope(const ProfileScope &) = delete;
+  ProfileScope &operator=(const ProfileScope &) = delete;
+
+private:
+  Profiler &m_profiler;
+  int m_section;
+  std::chrono::steady_clock::time_point m_start;
+};
+
+#endif // PROFILER_H
@@ -50,6 +50,12 @@ public:
 
   Mat4f matrix4f() const;
 
+  // Columns of matrix4f(), the rotated x, y and z axes, without building
+  // the matrix
+  Vec3f xAxis() const;
+  Vec3f yAxis() const;
+  Vec3f zAxis() const;
+
 private:
   float m_re;
   Vec3f m_im;
@@ -60,6 +66,10 @@ Quat4f operator*(float scalar, Quat4f const &q);
 std::ostream &operator<<(std::ostream &out, Quat4f const &q);
 
 Quat4f slerp(Quat4f const &q0, Quat4f const &q1, float t);
+
+// Rotation whose matrix has the orthonormal (right handed) columns x, y and
+// z, the inverse of the axis accessors
+Quat4f rotationFromAxes(Vec3f const &x, Vec3f const &y, Vec3f const &z);
 Vec3f rotateAround(Vec3f const &vec, Vec3f const &axis, float radians);
 void rotateAround(Vec3f &vec, Vec3f const &axis, float radians);
 
@@ -183,6 +193,24 @@ inline Mat4f Quat4f::matrix4f() const {
   return result;
 }
 
+inline Vec3f Quat4f::xAxis() const {
+  float x = m_im.x(), y = m_im.y(), z = m_im.z(), w = m_re;
+  return Vec3f(1.f - 2.f * (y * y + z * z), 2.f * (x * y + w * z),
+               2.f * (x * z - w * y));
+}
+
+inline Vec3f Quat4f::yAxis() const {
+  float x = m_im.x(), y = m_im.y(), z = m_im.z(), w = m_re;
+  return Vec3f(2.f * (x * y - w * z), 1.f - 2.f * (x * x + z * z),
+               2.f * (y * z + w * x));
+}
+
+inline Vec3f Quat4f::zAxis() const {
+  float x = m_im.x(), y = m_im.y(), z = m_im.z(), w = m_re;
+  return Vec3f(2.f * (x * z + w * y), 2.f * (y * z - w * x),
+               1.f - 2.f * (x * x + y * y));
+}
+
 inline void Quat4f::operator*=(Quat4f const &q) { *this = (*this * q); }
 
 inline float Quat4f::norm() const { return std::sqrt(normSquared()); }
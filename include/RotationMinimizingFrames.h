@@ -0,0 +1,90 @@
+/**
+ * File:	RotationMinimizingFrames.h
+ *
+ * Summary:
+ *
+ * Orientation along a track, one per sample of its ArcLengthTable, so
+ * orienting a car (or a camera riding along) is a lookup and a slerp
+ * instead of evaluating derivatives.
+ *
+ * Frenet frames follow the curvature, flip at inflection points and are
+ * undefined on straights. These are rotation minimizing frames instead,
+ * computed with the double reflection method (Wang, Juettler, Zheng and
+ * Liu, "Computation of Rotation Minimizing Frames", 2008): the frame of a
+ * sample is the previous one reflected in the plane bisecting the two
+ * sample points, then in the plane that takes the reflected tangent to the
+ * new tangent. The result does not roll about the tangent more than the
+ * curve forces it to.
+ *
+ * Each segment is done on its own, starting with the up vector closest to
+ * worldUp, and the roll about the tangent that makes it continue the
+ * segment before it is kept per segment. Segments are therefore computed in
+ * parallel, and after an edit only the edited ones are computed again; the
+ * rolls of the segments after them are a running sum over the segments.
+ *
+ * On a closed track the frame at the end does not in general match the one
+ * at the start (the curve's holonomy). That difference is spread evenly over
+ * the arc length, so the frames meet where the track does.
+ *
+ * A frame is stored as a Quat4f rotating the local axes to world space:
+ * +x right, +y up and -z forward (along the direction of travel), the axes
+ * of an OpenGL camera.
+ */
+
+#ifndef ROTATION_MINIMIZING_FRAMES_H
+#define ROTATION_MINIMIZING_FRAMES_H
+
+#include <cstddef>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "ArcLengthTable.h"
+#include "Quat4f.h"
+
+class RotationMinimizingFrames {
+public:
+  RotationMinimizingFrames();
+
+  // A frame per sample of track, which needs at least one segment
+  void build(ArcLengthTable const &track,
+             glm::vec3 const &worldUp = glm::vec3(0.f, 1.f, 0.f));
+
+  // After ArcLengthTable::update(track's control points, segments)
+  void update(ArcLengthTable const &track, std::vector<int> const &segments);
+
+  void clear();
+  bool empty() const;
+  std::size_t size() const; // number of samples
+
+  // Angle about the tangent spread over a closed track, 0 for open ones
+  float closingTwist() const;
+
+  // Frame at a sample of the table the frames were built from
+  Quat4f orientationAt(ArcLengthSample const &sample) const;
+
+  // Frame of a single sample, at arc length distance
+  Quat4f orientation(std::size_t sample, float distance) const;
+
+private:
+  void computeSegment(ArcLengthTable const &track, int segment);
+  float rollStep(int segment) const;
+  void accumulateRolls(ArcLengthTable const &track, int firstSegment);
+  float roll(std::size_t sample, float distance) const;
+
+private:
+  glm::vec3 m_worldUp;
+  std::size_t m_samplesPerSegment; // table samples of each segment
+
+  // per sample, rotation minimizing within its own segment
+  std::vector<Quat4f> m_localFrames;
+  // per segment, roll about the tangent continuing the segment before, and
+  // the sum of those up to the segment
+  std::vector<float> m_rollSteps;
+  std::vector<double> m_rolls;
+
+  float m_closingTwist;
+  float m_length;
+};
+
+#endif // ROTATION_MINIMIZING_FRAMES_H
@@ -0,0 +1,90 @@
+/**
+ * File:	ShaderProgram.h
+ *
+ * Summary:
+ *
+ * Owns a program made by CreateShaderProgram (see ShaderTools.h).
+ *
+ * Right after linking, every active uniform and attribute is queried once
+ * and its location is kept in a flat table, so looking a name up never goes
+ * to the driver. Look locations up at setup time and keep the GLint, the
+ * typed setters then only cost the glUniform* call itself.
+ *
+ * use() remembers the currently bound program and skips redundant
+ * glUseProgram calls. It assumes every program is bound through use().
+ */
+
+#ifndef SHADER_PROGRAM_H
+#define SHADER_PROGRAM_H
+
+#include "glad/glad.h"
+
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+class ShaderProgram {
+public:
+  struct Variable {
+    std::string name; // arrays are stored without the trailing "[0]"
+    GLint location;
+    GLenum type;
+    GLint size;
+  };
+
+public:
+  ShaderProgram();
+  ~ShaderProgram();
+
+  ShaderProgram(ShaderProgram &&moved);
+  ShaderProgram &operator=(ShaderProgram &&moved);
+
+  // Returns false (and stays invalid) if compiling or linking fails
+  bool create(const std::string &vsSource, const std::string &fsSource);
+  bool create(const std::string &vsSource, const std::string &gsSource,
+              const std::string &fsSource);
+  // Takes ownership of an already linked program
+  bool adopt(GLuint programID);
+  void destroy();
+
+  bool isValid() const;
+  GLuint id() const;
+
+  void use() const;
+
+  // -1 if name is not an active uniform / attribute
+  GLint uniformLocation(const std::string &name) const;
+  GLint attributeLocation(const std::string &name) const;
+
+  // Binds the named uniform block to a binding point.
+  // Returns false if the block does not exist.
+  bool bindUniformBlock(const std::string &name, GLuint binding) const;
+
+  std::vector<Variable> const &uniforms() const;
+  std::vector<Variable> const &attributes() const;
+
+  // Typed setters, bind the program first (if needed).
+  // A location of -1 is ignored, as with glUniform*.
+  void setUniform(GLint location, int value) const;
+  void setUniform(GLint location, float value) const;
+  void setUniform(GLint location, float x, float y, float z) const;
+  void setUniform(GLint location, glm::vec3 const &value) const;
+  void setUniform(GLint location, glm::vec4 const &value) const;
+  void setUniform(GLint location, glm::mat4 const &value) const;
+
+private:
+  ShaderProgram(ShaderProgram const &) = delete;
+  ShaderProgram &operator=(ShaderProgram const &) = delete;
+
+  void queryVariables();
+
+private:
+  GLuint m_id;
+  std::vector<Variable> m_uniforms;
+  std::vector<Variable> m_attributes;
+
+  static GLuint s_boundProgram;
+};
+
+#endif // SHADER_PROGRAM_H
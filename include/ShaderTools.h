@@ -36,9 +36,50 @@ GLuint CreateShaderProgram(const std::string &vsSource,
                            const std::string &gsSource,
                            const std::string &fsSource);
 
+/* Camera Block
+        Every program made by CreateShaderProgram that declares the uniform
+        block CAMERA_MATRICES_BLOCK has it bound to CAMERA_MATRICES_BINDING,
+        so one buffer bound there once per frame feeds all of them:
+
+        layout( std140 ) uniform CameraMatrices
+        {
+                mat4 view;
+                mat4 projection;
+                mat4 viewProjection;
+        };
+*/
+const char *const CAMERA_MATRICES_BLOCK = "CameraMatrices";
+const GLuint CAMERA_MATRICES_BINDING = 1;
+
+void bindCameraMatricesBlock(GLuint programID);
+
 bool checkCompileStatus(GLint shaderID);
 bool checkLinkStatus(GLint programID);
 
 std::string loadShaderStringfromFile(const std::string &filePath);
 
+/* Program Binary Cache
+        glGetProgramBinary/glProgramBinary (GL 4.1 or GL_ARB_get_program_binary)
+        are not part of the GL 4.0 glad loader, call
+        loadProgramBinaryFunctions() with the context's loader
+        (e.g. glfwGetProcAddress) once the context is current.
+
+        CreateCachedShaderProgram() keys each program by a hash of its
+        sources and the GL vendor, renderer and version strings. On a hit
+        the linked binary is loaded from cacheDir and compilation is
+        skipped. On a miss, or when the driver rejects the stored binary
+        (which deletes it), the program is compiled with
+        CreateShaderProgram() and its binary written back to the cache.
+        Without driver support it simply compiles every time.
+*/
+bool loadProgramBinaryFunctions(GLADloadproc load);
+bool programBinarySupported();
+
+GLuint CreateCachedShaderProgram(const std::string &vsSource,
+                                 const std::string &fsSource,
+                                 const std::string &cacheDir);
+
+std::string programCacheKey(const std::string &vsSource,
+                            const std::string &fsSource);
+
 #endif // SHADER_TOOLS_H
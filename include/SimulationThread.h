@@ -0,0 +1,68 @@
+/**
+ * File:	SimulationThread.h
+ *
+ * Summary:
+ *
+ * Runs a FixedStepScheduler on its own thread, so simulation steps and
+ * rendering (buffer swaps, vsync, uploads) no longer hold each other up.
+ *
+ * The thread wakes up when the next step is due, runs the steps the
+ * scheduler asks for and then calls publish(scheduler), which is where the
+ * new state should be copied out, e.g. into a TripleBuffer the render
+ * thread reads. step() and publish() only ever run on the simulation
+ * thread, so the state they touch needs no locking as long as nothing else
+ * touches it while the thread runs.
+ *
+ * Pausing and the time scale are atomics the render thread may change at
+ * any time; they take effect at the next wake up.
+ */
+
+#ifndef SIMULATION_THREAD_H
+#define SIMULATION_THREAD_H
+
+#include <atomic>
+#include <functional>
+#include <thread>
+
+#include "FixedStepScheduler.h"
+
+class SimulationThread {
+public:
+  typedef std::function<void(double time, double dt)> StepFunction;
+  typedef std::function<void(FixedStepScheduler const &)> PublishFunction;
+
+public:
+  SimulationThread();
+  ~SimulationThread(); // stops the thread
+
+  SimulationThread(const SimulationThread &) = delete;
+  SimulationThread &operator=(const SimulationThread &) = delete;
+
+  // The scheduler is copied, its step length and cap are used as they are
+  void start(FixedStepScheduler const &scheduler, StepFunction step,
+             PublishFunction publish);
+  void stop(); // waits for the current update to finish
+
+  bool running() const;
+
+  void setPaused(bool paused);
+  bool paused() const;
+
+  void setTimeScale(double scale);
+  double timeScale() const;
+
+private:
+  void run();
+
+private:
+  std::thread m_thread;
+  FixedStepScheduler m_scheduler;
+  StepFunction m_step;
+  PublishFunction m_publish;
+
+  std::atomic<bool> m_running;
+  std::atomic<bool> m_paused;
+  std::atomic<double> m_timeScale;
+};
+
+#endif // SIMULATION_THREAD_H
@@ -0,0 +1,138 @@
+/**
+ * File:	ThreadPool.h
+ *
+ * Summary:
+ *
+ * Small work-stealing job system for data parallel loops.
+ *
+ * parallelFor(first, last, grain, body) cuts [first, last) into chunks of
+ * at most grain indices and calls body(begin, end) once per chunk, on the
+ * pool's workers and on the calling thread, and returns when every chunk is
+ * done. Chunks are dealt round robin to one queue per thread; a thread
+ * takes work from the back of its own queue and, when that is empty, steals
+ * from the front of the others, so uneven chunks (e.g. curve segments that
+ * need very different subdivision) still balance out.
+ *
+ * The calling thread runs chunks while it waits, so nested parallelFor calls
+ * from inside a body are fine and a pool with no workers simply runs the
+ * loop inline.
+ *
+ * Chunk boundaries depend only on first and grain. Results should go to
+ * slices of an output sized up front (chunk i writes only its own indices)
+ * and be combined in index order afterwards: the output is then the same
+ * whatever the number of threads or the order in which chunks happen to
+ * run.
+ *
+ * body must not throw.
+ */
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool {
+public:
+  // numWorkers threads besides the callers, -1 for one less than the number
+  // of hardware threads (the caller is the remaining one)
+  explicit ThreadPool(int numWorkers = -1);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  int numWorkers() const;
+  int concurrency() const; // workers plus the calling thread
+
+  template <typename Body>
+  void parallelFor(std::size_t first, std::size_t last, std::size_t grain,
+                   Body body);
+
+  // Process wide pool, created on first use. Its size can be set with the
+  // QUAD_ANIMATION_THREADS environment variable (number of threads in
+  // total, 1 to run everything on the calling thread).
+  static ThreadPool &global();
+
+private:
+  // One parallelFor call, shared by its chunks
+  struct Job {
+    void (*run)(void *body, std::size_t begin, std::size_t end);
+    void *body;
+    std::atomic<std::size_t> remaining;
+  };
+
+  struct Task {
+    Job *job;
+    std::size_t begin;
+    std::size_t end;
+  };
+
+  struct TaskQueue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  template <typename Body>
+  static void runBody(void *body, std::size_t begin, std::size_t end);
+
+  void submitAndWait(Job &job, std::size_t first, std::size_t last,
+                     std::size_t grain);
+  bool runOneTask(std::size_t home);
+  bool popTask(std::size_t queue, bool fromBack, Task &task);
+  void workerLoop(std::size_t index);
+  std::size_t callerQueue() const;
+
+private:
+  std::vector<std::thread> m_workers;
+  // one per worker, then one shared by every thread outside the pool
+  std::vector<std::unique_ptr<TaskQueue>> m_queues;
+
+  std::atomic<std::size_t> m_pendingTasks;
+  std::mutex m_wakeMutex;
+  std::condition_variable m_wake;
+  bool m_stopping;
+};
+
+template <typename Body>
+void ThreadPool::runBody(void *body, std::size_t begin, std::size_t end) {
+  (*static_cast<Body *>(body))(begin, end);
+}
+
+template <typename Body>
+void ThreadPool::parallelFor(std::size_t first, std::size_t last,
+                             std::size_t grain, Body body) {
+  if (first >= last)
+    return;
+  if (grain == 0)
+    grain = 1;
+
+  // same chunks when run inline, so per chunk results never depend on the
+  // number of threads
+  if (m_workers.empty() || last - first <= grain) {
+    for (std::size_t begin = first; begin < last; begin += grain)
+      body(begin, begin + std::min(grain, last - begin));
+    return;
+  }
+
+  Job job;
+  job.run = &runBody<Body>;
+  job.body = &body;
+  submitAndWait(job, first, last, grain);
+}
+
+// parallelFor on ThreadPool::global()
+template <typename Body>
+void parallelFor(std::size_t first, std::size_t last, std::size_t grain,
+                 Body body) {
+  ThreadPool::global().parallelFor(first, last, grain, body);
+}
+
+#endif // THREAD_POOL_H
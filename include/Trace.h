@@ -0,0 +1,127 @@
+/**
+ * File:	Trace.h
+ *
+ * Summary:
+ *
+ * Begin and end events of what ran when, on which thread, written as a
+ * Chrome trace event JSON file that chrome://tracing and Perfetto
+ * (ui.perfetto.dev) open as a timeline. Where the Profiler (Profiler.h)
+ * says how long sections take on average, a trace shows the single slow
+ * frame or the start up in order.
+ *
+ *   Tracer::global().start();
+ *   ...
+ *   {
+ *     TraceScope scope("loadTrack", "load");
+ *     loadTrack(...);
+ *   }
+ *   ...
+ *   Tracer::global().writeJson("trace.json");
+ *
+ * Each thread appends its events to a buffer of its own, a list of fixed
+ * size chunks that only that thread writes to, so recording takes no lock
+ * and never moves what was recorded: writeJson() may read the buffers while
+ * threads keep appending. The only lock is taken once per thread, when its
+ * buffer is made.
+ *
+ * Names and categories are not copied, they must outlive the tracer (string
+ * literals). While the tracer is stopped a TraceScope costs a load of a
+ * flag.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class Tracer {
+public:
+  // The tracer every TraceScope records into. It is never destroyed, so
+  // threads may record until the process exits.
+  static Tracer &global();
+
+  Tracer(const Tracer &) = delete;
+  Tracer &operator=(const Tracer &) = delete;
+
+  void start(); // timestamps are from when the tracer was made
+  void stop();
+  bool enabled() const;
+
+  // Events of the calling thread, name and category as for TraceScope.
+  // Nothing is recorded while stopped.
+  void begin(char const *name, char const *category = "");
+  void end(char const *name, char const *category = "");
+
+  // Shown instead of the thread's number, e.g. "main" or "simulation"
+  void setThreadName(char const *name);
+
+  // Every event recorded so far, false if fileName could not be written
+  bool writeJson(std::string const &fileName) const;
+
+  std::size_t numEvents() const;
+
+private:
+  struct Event {
+    char const *name;
+    char const *category;
+    long long nanoseconds; // since m_epoch
+    char phase;            // 'B' or 'E'
+  };
+
+  enum { EVENTS_PER_CHUNK = 4096 };
+
+  // Written by its thread only. count is published with release after the
+  // event is stored, so a reader seeing count sees the events below it.
+  struct Chunk {
+    Event events[EVENTS_PER_CHUNK];
+    std::atomic<std::size_t> count;
+    std::atomic<Chunk *> next;
+    Chunk();
+  };
+
+  struct ThreadBuffer {
+    int id; // from 1, in the order threads first record
+    std::atomic<char const *> name;
+    std::atomic<Chunk *> head; // made by the first event
+    Chunk *tail;               // only the owning thread uses it
+    ThreadBuffer();
+    ~ThreadBuffer();
+  };
+
+private:
+  Tracer();
+
+  ThreadBuffer &threadBuffer();
+  void append(char phase, char const *name, char const *category);
+
+private:
+  std::atomic<bool> m_enabled;
+  std::chrono::steady_clock::time_point m_epoch;
+
+  mutable std::mutex m_threadsMutex;
+  std::vector<std::unique_ptr<ThreadBuffer>> m_threads;
+};
+
+// A begin event at construction and its end event at destruction, each
+// recorded if the global tracer is running then
+class TraceScope {
+public:
+  explicit TraceScope(char const *name, char const *category = "");
+  ~TraceScope();
+
+  TraceScope(const TraceScope &) = delete;
+  TraceScope &operator=(const TraceScope &) = delete;
+
+private:
+  char const *m_name;
+  char const *m_category;
+  bool m_recording;
+};
+
+#endif // TRACE_H
@@ -0,0 +1,131 @@
+/**
+ * File:	TrackFile.h
+ *
+ * Summary:
+ *
+ * Binary track format, the counterpart of the text control point files read
+ * by loadVec3fFromFile.
+ *
+ * Layout (native byte order, little endian on every platform we build for):
+ *
+ *   TrackFileHeader        64 bytes
+ *   control points         numPoints * 3 float32 (x y z), 16 byte aligned
+ *   arc length table       numArcLengths float32, 16 byte aligned (optional)
+ *
+ * The arc length table holds the cumulative lengths of ArcLengthTable::build
+ * for arcLengthSamplesPerSegment, so a viewer can skip sampling the curve.
+ *
+ * MappedTrackFile maps the file read only and points straight into the
+ * mapping: opening costs a few system calls regardless of the track size,
+ * and points() can be handed to glBufferData without an intermediate copy.
+ * Pages are only read from disk when they are first touched.
+ */
+
+#ifndef TRACK_FILE_H
+#define TRACK_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+class ArcLengthTable;
+
+enum { TRACK_FILE_VERSION = 1, TRACK_FILE_ALIGNMENT = 16 };
+
+enum TrackFileFlags { TRACK_HAS_ARC_LENGTHS = 1 << 0 };
+
+struct TrackFileHeader {
+  char magic[8];     // TRACK_FILE_MAGIC
+  uint32_t version;  // TRACK_FILE_VERSION when written
+  uint32_t flags;    // TrackFileFlags
+  uint64_t numPoints;
+  uint64_t pointsOffset; // bytes from the start of the file
+  uint32_t arcLengthSamplesPerSegment;
+  uint32_t reserved;
+  uint64_t numArcLengths;
+  uint64_t arcLengthsOffset;
+  uint64_t fileSize;
+};
+
+static_assert(sizeof(TrackFileHeader) == 64, "TrackFileHeader must be packed");
+static_assert(sizeof(glm::vec3) == 3 * sizeof(float),
+              "points are read in place as glm::vec3");
+
+extern const char TRACK_FILE_MAGIC[8];
+
+class MappedTrackFile {
+public:
+  MappedTrackFile();
+  ~MappedTrackFile();
+
+  MappedTrackFile(MappedTrackFile &&moved);
+  MappedTrackFile &operator=(MappedTrackFile &&moved);
+
+  MappedTrackFile(const MappedTrackFile &) = delete;
+  MappedTrackFile &operator=(const MappedTrackFile &) = delete;
+
+  // Maps fileName and validates the header, returns false (see error()) if
+  // the file cannot be mapped or is not a track file this code understands.
+  bool open(std::string const &fileName);
+  void close();
+
+  bool isOpen() const;
+  std::string const &error() const;
+
+  TrackFileHeader const &header() const;
+
+  // Valid until close(), the pointers refer to the mapping
+  std::size_t numPoints() const;
+  glm::vec3 const *points() const;
+  std::size_t pointsByteSize() const;
+
+  bool hasArcLengths() const;
+  int arcLengthSamplesPerSegment() const;
+  std::size_t numArcLengths() const;
+  float const *arcLengths() const;
+
+  // Fills table from the stored lengths, or samples the curve if the file
+  // has none. Copies the control points, the table owns its data.
+  void loadArcLengthTable(ArcLengthTable &table) const;
+  // As above, with controlPoints a copy of points() the caller already made
+  void loadArcLengthTable(std::vector<glm::vec3> const &controlPoints,
+                          ArcLengthTable &table) const;
+
+private:
+  bool fail(std::string const &message);
+
+private:
+  void *m_mapping;
+  std::size_t m_mappedSize;
+  TrackFileHeader const *m_header;
+  std::string m_error;
+};
+
+// Writes points (and, if table is not null, its lengths) as a track file.
+// On failure returns false and describes the problem in *error if given.
+bool writeTrackFile(std::string const &fileName, glm::vec3 const *points,
+                    std::size_t numPoints, ArcLengthTable const *table,
+                    std::string *error = nullptr);
+
+// Text control point file (see Vec3f_FileIO.h) to binary track file. The arc
+// length table is sampled with samplesPerSegment, or left out if it is 0.
+bool convertTextTrackFile(std::string const &textFileName,
+                          std::string const &trackFileName,
+                          int samplesPerSegment, std::string *error = nullptr);
+
+// The track shown when no file is given: two hills, closed at the origin
+std::vector<glm::vec3> defaultTrackControlPoints();
+
+// Control points from a binary track file (.trk, its arc length table is
+// used when present) or a text control point file, and table built for
+// them. Returns false if the file cannot be read or holds no complete Bezier
+// segment. Unparsable lines of a text file are skipped; they are described
+// in *error even though the load succeeds.
+bool loadTrack(std::string const &fileName,
+               std::vector<glm::vec3> &controlPoints, ArcLengthTable &table,
+               std::string *error = nullptr);
+
+#endif // TRACK_FILE_H
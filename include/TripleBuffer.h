@@ -0,0 +1,69 @@
+/**
+ * File:	TripleBuffer.h
+ *
+ * Summary:
+ *
+ * Lock-free single producer, single consumer hand over of the latest value.
+ *
+ * Three T are kept: one the producer writes, one the consumer reads, and
+ * one in between holding the most recently published value. publish() and
+ * update() each swap their own buffer with the middle one in one atomic
+ * exchange, so neither side ever waits for the other and the consumer always
+ * sees a complete value. Values the consumer did not get to in time are
+ * simply overwritten (it only ever wants the newest).
+ *
+ * The buffers are reused, so a T holding vectors stops allocating once
+ * their capacity has grown to the largest size written.
+ *
+ *   producer:  T &next = buffer.writeBuffer(); fill(next); buffer.publish();
+ *   consumer:  buffer.update(); use(buffer.readBuffer());
+ */
+
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <atomic>
+#include <cstdint>
+
+template <typename T> class TripleBuffer {
+public:
+  TripleBuffer() : m_write(0), m_middle(1), m_read(2) {}
+
+  TripleBuffer(const TripleBuffer &) = delete;
+  TripleBuffer &operator=(const TripleBuffer &) = delete;
+
+  // ===== producer ===== //
+  T &writeBuffer() { return m_buffers[m_write]; }
+
+  // Makes the write buffer the newest value, and continues in the buffer
+  // the consumer is not using
+  void publish() {
+    std::uint8_t previous =
+        m_middle.exchange(m_write | NEW_VALUE, std::memory_order_acq_rel);
+    m_write = previous & INDEX_MASK;
+  }
+
+  // ===== consumer ===== //
+  // Switches to the newest published value, returns false (keeping the
+  // current one) if nothing was published since the last call
+  bool update() {
+    if (!(m_middle.load(std::memory_order_relaxed) & NEW_VALUE))
+      return false;
+
+    std::uint8_t previous = m_middle.exchange(m_read, std::memory_order_acq_rel);
+    m_read = previous & INDEX_MASK;
+    return true;
+  }
+
+  T const &readBuffer() const { return m_buffers[m_read]; }
+
+private:
+  enum : std::uint8_t { INDEX_MASK = 0x3, NEW_VALUE = 0x4 };
+
+  T m_buffers[3];
+  std::uint8_t m_write;              // producer only
+  std::atomic<std::uint8_t> m_middle; // index, and NEW_VALUE if unread
+  std::uint8_t m_read;               // consumer only
+};
+
+#endif // TRIPLE_BUFFER_H
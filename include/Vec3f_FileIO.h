@@ -5,85 +5,180 @@
 #include <iostream>
 #include <string>
 #include <cstddef>
+#include <cstring>
 #include <vector>
-#include <sstream>
-#include <iterator>
 #include <fstream>
-#include <stdexcept>
+#include <charconv>
+#include <system_error>
 #include "Vec3f.h"
+#include "Trace.h"
 
 typedef std::vector< Vec3f > VectorContainerVec3f;
 
-// i) Reads in file (e.g. text file (.txt) or contour file (.con)).
-// ii) Parses it line by line.
-// iii) Extracts the first three floating point values (ignoring all other values)
-// iv) Stores these values as a Vec3f in a vector container
-void loadVec3fFromFile( VectorContainerVec3f & vecs, std::string const & fileName )
+// Outcome of a load. Lines that cannot be parsed are skipped and counted,
+// the first one is described in message.
+struct Vec3fFileStatus
 {
-	using std::string;
-	using std::stringstream;
-	using std::istream_iterator;
+	bool opened = false;
+	std::size_t numLines = 0;
+	std::size_t numErrors = 0;
+	std::size_t firstErrorLine = 0;
+	std::string message;
 
-	std::ifstream file( fileName );
+	bool ok() const { return opened && numErrors == 0; }
+};
 
-	if( !file )
+namespace Vec3fFileIO_detail
+{
+	inline bool isSpace( char c )
 	{
-		throw std::runtime_error( "Unable to open file." );
+		return c == ' ' || c == '\t' || c == '\r' || c == '\n'
+			|| c == '\v' || c == '\f';
 	}
 
-	string line;
-	size_t index;
-	stringstream ss( std::ios_base::in );
+	// Parses one float starting at `first` after skipping whitespace, like
+	// operator>> (which also accepts a leading '+', from_chars does not).
+	inline const char * parseFloat( const char * first, const char * last,
+	                                float & value )
+	{
+		while( first != last && isSpace( *first ) )
+		{
+			++first;
+		}
+
+		if( first != last && *first == '+' )
+		{
+			++first;
+			if( first == last || *first == '-' )
+			{
+				return nullptr;
+			}
+		}
 
-	size_t lineNum = 0;
-	vecs.clear();
+		std::from_chars_result result = std::from_chars( first, last, value );
+		if( result.ec != std::errc() )
+		{
+			return nullptr;
+		}
+		return result.ptr;
+	}
+}
+
+// i) Parses text already in memory (e.g. a whole file), line by line.
+// ii) Ignores everything after a '#' and lines that are only whitespace.
+// iii) Extracts the first three floating point values (ignoring all other values)
+// iv) Appends these values as a Vec3f to vecs, reserving space up front
+// Never allocates per line, and never throws on bad input.
+inline Vec3fFileStatus parseVec3fBuffer( VectorContainerVec3f & vecs,
+                                         const char * begin, const char * end )
+{
+	using namespace Vec3fFileIO_detail;
+
+	Vec3fFileStatus status;
+	status.opened = true;
+
+	// one vector per line at most
+	std::size_t numLines = 1;
+	for( const char * p = begin;
+	     ( p = static_cast< const char * >( std::memchr( p, '\n', end - p ) ) );
+	     ++p )
+	{
+		++numLines;
+	}
+	vecs.reserve( vecs.size() + numLines );
 
-	while( getline( file, line ) )
+	const char * line = begin;
+	while( line < end )
 	{
-		++lineNum;
+		++status.numLines;
 
-		// remove comments
-		index = line.find_first_of( "#" );
-		if( index != string::npos )
+		const char * lineEnd = static_cast< const char * >(
+			std::memchr( line, '\n', end - line ) );
+		if( !lineEnd )
 		{
-			line.erase( index, string::npos );
+			lineEnd = end;
 		}
 
-		// removes leading/tailing junk
-		line.erase( 0, line.find_first_not_of( " \t\r\n\v\f" ) );
-		index = line.find_last_not_of( " \t\r\n\v\f" )+1;
-		if( index != string::npos )
+		// remove comments
+		const char * contentEnd = static_cast< const char * >(
+			std::memchr( line, '#', lineEnd - line ) );
+		if( !contentEnd )
 		{
-			line.erase( index, string::npos );
+			contentEnd = lineEnd;
 		}
 
-		if( line.empty() )
+		// empty or commented out line
+		const char * p = line;
+		while( p != contentEnd && isSpace( *p ) )
 		{
-			continue; // empty or commented out line
+			++p;
 		}
 
-		ss.str( line );
-		ss.clear();
-
-		try{
-			Vec3f v;
-			ss >> v;
+		if( p != contentEnd )
+		{
+			float xyz[3];
+			for( int i = 0; i < 3 && p; ++i )
+			{
+				p = parseFloat( p, contentEnd, xyz[i] );
+			}
 
-			if( !ss )
+			if( p )
 			{
-				throw std::runtime_error( "Error read file: "
-							 + line
-							 + " (line: "
-							 + std::to_string(lineNum)
-							 +  ")" );
+				vecs.push_back( Vec3f( xyz[0], xyz[1], xyz[2] ) );
 			}
 			else
 			{
-				vecs.push_back( v );
+				if( status.numErrors == 0 )
+				{
+					status.firstErrorLine = status.numLines;
+					status.message = "Error read file: "
+						+ std::string( line, contentEnd )
+						+ " (line: "
+						+ std::to_string( status.numLines )
+						+ ")";
+				}
+				++status.numErrors;
 			}
-		} catch (const std::exception & e) { std::cerr << e.what() << std::endl; }
+		}
+
+		line = lineEnd + 1;
+	}
+
+	return status;
+}
+
+// Reads the whole file (e.g. text file (.txt) or contour file (.con)) into
+// one buffer and parses it with parseVec3fBuffer. vecs is cleared first.
+inline Vec3fFileStatus loadVec3fFromFile( VectorContainerVec3f & vecs,
+                                          std::string const & fileName )
+{
+	TraceScope scope( "loadVec3fFromFile", "load" );
+
+	vecs.clear();
+
+	std::ifstream file( fileName, std::ios::in | std::ios::binary );
+
+	if( !file )
+	{
+		Vec3fFileStatus status;
+		status.message = "Unable to open file: " + fileName;
+		return status;
+	}
+
+	file.seekg( 0, std::ios::end );
+	std::streamoff size = file.tellg();
+	file.seekg( 0, std::ios::beg );
+
+	std::vector< char > buffer( size > 0 ? static_cast< std::size_t >( size ) : 0 );
+	if( !buffer.empty() && !file.read( buffer.data(), buffer.size() ) )
+	{
+		Vec3fFileStatus status;
+		status.message = "Unable to read file: " + fileName;
+		return status;
 	}
 	file.close();
+
+	return parseVec3fBuffer( vecs, buffer.data(), buffer.data() + buffer.size() );
 }
 
 #endif
@@ -1,13 +1,29 @@
 #version 330
 layout( location = 0 ) in vec3 vert_modelSpace;
 
-uniform mat4 MVP;
+// Written once per frame, shared by all programs
+layout( std140 ) uniform CameraMatrices
+{
+	mat4 view;
+	mat4 projection;
+	mat4 viewProjection;
+};
+
+// One model matrix per object
+const int MAX_OBJECTS = 256;
+layout( std140 ) uniform ObjectTransforms
+{
+	mat4 models[ MAX_OBJECTS ];
+};
+
+uniform int objectIndex;
 uniform vec3 inputColor;
 
 out vec3 interpolateColor;
 
 void main()
 {
-	gl_Position = MVP * vec4( vert_modelSpace, 1.0 );
+	gl_Position = viewProjection * models[ objectIndex ] *
+	              vec4( vert_modelSpace, 1.0 );
 	interpolateColor = inputColor;
 }
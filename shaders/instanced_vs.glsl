@@ -0,0 +1,35 @@
+#version 330
+layout( location = 0 ) in vec3 vert_modelSpace;
+
+// Per instance, see InstanceTransform.h
+layout( location = 1 ) in vec4 instancePositionScale;
+layout( location = 2 ) in vec4 instanceOrientation;
+
+// Written once per frame, shared by all programs
+layout( std140 ) uniform CameraMatrices
+{
+	mat4 view;
+	mat4 projection;
+	mat4 viewProjection;
+};
+
+uniform vec3 inputColor;
+
+out vec3 interpolateColor;
+
+// Rotates v by the unit quaternion q = (x, y, z, w)
+vec3 rotate( vec4 q, vec3 v )
+{
+	vec3 t = 2.0 * cross( q.xyz, v );
+	return v + q.w * t + cross( q.xyz, t );
+}
+
+void main()
+{
+	vec3 worldSpace = rotate( instanceOrientation,
+	                          vert_modelSpace * instancePositionScale.w )
+	                  + instancePositionScale.xyz;
+
+	gl_Position = viewProjection * vec4( worldSpace, 1.0 );
+	interpolateColor = inputColor;
+}
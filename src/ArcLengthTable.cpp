@@ -0,0 +1,323 @@
+/**
+ * File:	ArcLengthTable.cpp
+ */
+
+#include "ArcLengthTable.h"
+#include "BezierCurve.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+
+using glm::vec3;
+
+ArcLengthTable::ArcLengthTable() {}
+
+ArcLengthTable::ArcLengthTable(std::vector<vec3> const &controlPoints,
+                               int samplesPerSegment) {
+  build(controlPoints, samplesPerSegment);
+}
+
+// Samples t = 0, 1/n, ..., 1 on every segment. The last sample of a segment
+// and the first of the next share the same length, which gives a zero
+// length interval the searches below never land in.
+//
+// Segments are measured independently (in parallel), each from its own
+// start, then offset by the length of the segments before it.
+void ArcLengthTable::build(std::vector<vec3> const &controlPoints,
+                           int samplesPerSegment) {
+  clear();
+
+  int numSegments = numBezierSegments(controlPoints.size());
+  if (numSegments == 0 || samplesPerSegment < 1)
+    return;
+
+  m_controlPoints = controlPoints;
+
+  std::size_t samples = samplesPerSegment + 1;
+  std::size_t numSamples = static_cast<std::size_t>(numSegments) * samples;
+  m_lengths.resize(numSamples);
+  m_localLengths.resize(numSamples);
+  m_segments.resize(numSamples);
+  m_params.resize(numSamples);
+  m_segmentStarts.assign(numSegments + 1, 0.0);
+
+  float dt = 1.f / samplesPerSegment;
+
+  std::size_t grain = std::max<std::size_t>(4096 / samples, 1);
+  parallelFor(0, numSegments, grain, [&](std::size_t first, std::size_t last) {
+    for (std::size_t seg = first; seg < last; ++seg) {
+      for (int j = 0; j <= samplesPerSegment; ++j) {
+        std::size_t k = seg * samples + j;
+        m_segments[k] = int(seg);
+        m_params[k] = (j == samplesPerSegment) ? 1.f : j * dt;
+      }
+      measureSegment(int(seg), samplesPerSegment);
+    }
+  });
+
+  accumulate(0);
+}
+
+bool ArcLengthTable::update(std::vector<vec3> const &controlPoints,
+                            std::vector<int> const &segments) {
+  if (empty() || controlPoints.size() != m_controlPoints.size())
+    return false;
+  if (segments.empty())
+    return true;
+
+  for (int seg : segments)
+    std::copy(controlPoints.begin() + 3 * seg,
+              controlPoints.begin() + 3 * seg + 4,
+              m_controlPoints.begin() + 3 * seg);
+
+  int samplesPerSegment = this->samplesPerSegment();
+  std::size_t grain = std::max<std::size_t>(4096 / (samplesPerSegment + 1), 1);
+  parallelFor(0, segments.size(), grain,
+              [&](std::size_t first, std::size_t last) {
+                for (std::size_t i = first; i < last; ++i)
+                  measureSegment(segments[i], samplesPerSegment);
+              });
+
+  accumulate(segments.front());
+  return true;
+}
+
+// Length from the start of the segment at each of its samples, accumulated
+// in double as long segments drift in float
+void ArcLengthTable::measureSegment(int segment, int samplesPerSegment) {
+  vec3 const *p = &m_controlPoints[3 * segment];
+  std::size_t k = std::size_t(segment) * (samplesPerSegment + 1);
+
+  double length = 0.0;
+  vec3 previous = p[0];
+  for (int j = 0; j <= samplesPerSegment; ++j, ++k) {
+    vec3 point = calcPoint(p[0], p[1], p[2], p[3], m_params[k]);
+    length += glm::length(point - previous);
+    previous = point;
+
+    m_localLengths[k] = static_cast<float>(length);
+  }
+}
+
+// Running totals from firstSegment on, the ones before it are unchanged
+void ArcLengthTable::accumulate(int firstSegment) {
+  int numSegments = this->numSegments();
+  std::size_t samples = m_lengths.size() / numSegments;
+
+  for (int seg = firstSegment; seg < numSegments; ++seg)
+    m_segmentStarts[seg + 1] =
+        m_segmentStarts[seg] + m_localLengths[(seg + 1) * samples - 1];
+
+  std::size_t grain = std::max<std::size_t>(16384 / samples, 1);
+  parallelFor(firstSegment, numSegments, grain,
+              [&](std::size_t first, std::size_t last) {
+                for (std::size_t seg = first; seg < last; ++seg) {
+                  double start = m_segmentStarts[seg];
+                  for (std::size_t k = seg * samples; k < (seg + 1) * samples;
+                       ++k)
+                    m_lengths[k] = static_cast<float>(start + m_localLengths[k]);
+                }
+              });
+}
+
+bool ArcLengthTable::assign(std::vector<vec3> const &controlPoints,
+                            int samplesPerSegment, float const *lengths,
+                            std::size_t numLengths) {
+  clear();
+
+  int numSegments = numBezierSegments(controlPoints.size());
+  if (numSegments == 0 || samplesPerSegment < 1)
+    return false;
+
+  std::size_t samples = samplesPerSegment + 1;
+  std::size_t numSamples = static_cast<std::size_t>(numSegments) * samples;
+  if (numLengths != numSamples)
+    return false;
+
+  m_controlPoints = controlPoints;
+  m_lengths.assign(lengths, lengths + numLengths);
+  m_localLengths.resize(numSamples);
+  m_segmentStarts.resize(numSegments + 1);
+  m_segments.reserve(numSamples);
+  m_params.reserve(numSamples);
+
+  // same parameters as build()
+  float dt = 1.f / samplesPerSegment;
+  for (int seg = 0; seg < numSegments; ++seg) {
+    float start = lengths[seg * samples];
+    m_segmentStarts[seg] = start;
+
+    for (int j = 0; j <= samplesPerSegment; ++j) {
+      m_localLengths[seg * samples + j] = lengths[seg * samples + j] - start;
+      m_segments.push_back(seg);
+      m_params.push_back((j == samplesPerSegment) ? 1.f : j * dt);
+    }
+  }
+  m_segmentStarts[numSegments] = lengths[numLengths - 1];
+  return true;
+}
+
+void ArcLengthTable::clear() {
+  m_controlPoints.clear();
+  m_lengths.clear();
+  m_localLengths.clear();
+  m_segmentStarts.clear();
+  m_segments.clear();
+  m_params.clear();
+}
+
+bool ArcLengthTable::empty() const { return m_lengths.empty(); }
+
+std::size_t ArcLengthTable::size() const { return m_lengths.size(); }
+
+int ArcLengthTable::numSegments() const {
+  return m_segments.empty() ? 0 : m_segments.back() + 1;
+}
+
+int ArcLengthTable::samplesPerSegment() const {
+  int segments = numSegments();
+  return segments == 0 ? 0 : int(m_lengths.size() / segments) - 1;
+}
+
+float ArcLengthTable::totalLength() const {
+  return m_lengths.empty() ? 0.f : m_lengths.back();
+}
+
+float ArcLengthTable::segmentStart(int segment) const {
+  if (m_segmentStarts.empty())
+    return 0.f;
+
+  segment = std::max(0, std::min(segment, int(m_segmentStarts.size()) - 1));
+  return static_cast<float>(m_segmentStarts[segment]);
+}
+
+std::vector<float> const &ArcLengthTable::lengths() const { return m_lengths; }
+
+std::vector<vec3> const &ArcLengthTable::controlPoints() const {
+  return m_controlPoints;
+}
+
+void ArcLengthTable::seek(float s, ArcLengthCursor &cursor) const {
+  cursor.index = (m_lengths.size() < 2) ? 0 : findInterval(s);
+}
+
+float ArcLengthTable::wrap(float s) const {
+  float total = totalLength();
+  if (total <= 0.f)
+    return 0.f;
+
+  s = std::fmod(s, total);
+  return (s < 0.f) ? s + total : s;
+}
+
+// Index i of the interval [m_lengths[i], m_lengths[i+1]] containing s
+std::size_t ArcLengthTable::findInterval(float s) const {
+  std::vector<float>::const_iterator upper =
+      std::upper_bound(m_lengths.begin(), m_lengths.end(), s);
+
+  std::size_t i = upper - m_lengths.begin();
+  i = (i == 0) ? 0 : i - 1;
+  return std::min(i, m_lengths.size() - 2);
+}
+
+std::size_t ArcLengthTable::findInterval(float s,
+                                         ArcLengthCursor &cursor) const {
+  std::size_t last = m_lengths.size() - 2;
+  std::size_t i = std::min(cursor.index, last);
+
+  if (s < m_lengths[i]) {
+    // moved backwards (or wrapped around), start over
+    i = findInterval(s);
+  } else {
+    while (i < last && m_lengths[i + 1] <= s)
+      ++i;
+  }
+
+  cursor.index = i;
+  return i;
+}
+
+CurveParameter ArcLengthTable::interpolate(std::size_t i, float s) const {
+  CurveParameter param;
+
+  // skip the zero length interval between two segments
+  if (m_segments[i] != m_segments[i + 1]) {
+    param.segment = m_segments[i + 1];
+    param.t = 0.f;
+    return param;
+  }
+
+  float s0 = m_lengths[i];
+  float s1 = m_lengths[i + 1];
+  float u = (s1 > s0) ? (s - s0) / (s1 - s0) : 0.f;
+  u = std::max(0.f, std::min(1.f, u));
+
+  param.segment = m_segments[i];
+  param.t = m_params[i] + u * (m_params[i + 1] - m_params[i]);
+  return param;
+}
+
+CurveParameter ArcLengthTable::parameterAt(float s) const {
+  CurveParameter param = {0, 0.f};
+  if (m_lengths.size() < 2)
+    return param;
+
+  return interpolate(findInterval(s), s);
+}
+
+CurveParameter ArcLengthTable::parameterAt(float s,
+                                           ArcLengthCursor &cursor) const {
+  CurveParameter param = {0, 0.f};
+  if (m_lengths.size() < 2)
+    return param;
+
+  return interpolate(findInterval(s, cursor), s);
+}
+
+vec3 ArcLengthTable::positionAt(float s) const {
+  if (empty())
+    return vec3(0.f);
+
+  CurveParameter param = parameterAt(s);
+  return calcSegmentPoint(m_controlPoints, param.segment, param.t);
+}
+
+vec3 ArcLengthTable::positionAt(float s, ArcLengthCursor &cursor) const {
+  if (empty())
+    return vec3(0.f);
+
+  CurveParameter param = parameterAt(s, cursor);
+  return calcSegmentPoint(m_controlPoints, param.segment, param.t);
+}
+
+ArcLengthSample ArcLengthTable::sample(std::size_t i, float s) const {
+  ArcLengthSample result;
+  result.index = i;
+  result.distance = std::max(0.f, std::min(s, totalLength()));
+
+  // the zero length interval between two segments: the later one
+  float s0 = m_lengths[i];
+  float s1 = m_lengths[i + 1];
+  if (m_segments[i] != m_segments[i + 1] || s1 <= s0)
+    result.fraction = 1.f;
+  else
+    result.fraction = std::max(0.f, std::min(1.f, (s - s0) / (s1 - s0)));
+  return result;
+}
+
+ArcLengthSample ArcLengthTable::sampleAt(float s) const {
+  return sample(findInterval(s), s);
+}
+
+ArcLengthSample ArcLengthTable::sampleAt(float s,
+                                         ArcLengthCursor &cursor) const {
+  return sample(findInterval(s, cursor), s);
+}
+
+CurveParameter ArcLengthTable::sampleParameter(std::size_t sample) const {
+  CurveParameter param;
+  param.segment = m_segments[sample];
+  param.t = m_params[sample];
+  return param;
+}
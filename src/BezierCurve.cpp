@@ -0,0 +1,45 @@
+/**
+ * File:	BezierCurve.cpp
+ */
+
+#include "BezierCurve.h"
+
+using glm::vec3;
+
+vec3 lerp(vec3 a, vec3 b, float t) { return (a + (b - a) * t); }
+
+vec3 calcPoint(vec3 a, vec3 b, vec3 c, vec3 d, float t) {
+  vec3 ab, bc, cd, abbc, bccd;
+  ab = lerp(a, b, t);
+  bc = lerp(b, c, t);
+  cd = lerp(c, d, t);
+  abbc = lerp(ab, bc, t);
+  bccd = lerp(bc, cd, t);
+  return lerp(abbc, bccd, t);
+}
+
+// the quadratic of the differences, scaled by 3
+vec3 calcDerivative(vec3 a, vec3 b, vec3 c, vec3 d, float t) {
+  float u = 1.f - t;
+  return 3.f * (u * u * (b - a) + 2.f * u * t * (c - b) + t * t * (d - c));
+}
+
+int numBezierSegments(std::size_t numControlPoints) {
+  if (numControlPoints < 4)
+    return 0;
+  return static_cast<int>((numControlPoints - 1) / 3);
+}
+
+vec3 calcSegmentPoint(std::vector<vec3> const &controlPoints, int segment,
+                      float t) {
+  std::size_t i = 3 * static_cast<std::size_t>(segment);
+  return calcPoint(controlPoints[i], controlPoints[i + 1],
+                   controlPoints[i + 2], controlPoints[i + 3], t);
+}
+
+vec3 calcSegmentDerivative(std::vector<vec3> const &controlPoints,
+                           int segment, float t) {
+  std::size_t i = 3 * static_cast<std::size_t>(segment);
+  return calcDerivative(controlPoints[i], controlPoints[i + 1],
+                        controlPoints[i + 2], controlPoints[i + 3], t);
+}
@@ -11,8 +11,14 @@
  */
 
 #include "Camera.h"
+#include "Quat4f.h"
+
+#include <algorithm>
+
 Camera::Camera(vec3 const &pos, vec3 const &forward, vec3 const &up)
-    : m_focusDist(length(forward)), m_pos(pos), m_up(up), m_forward(forward) {}
+    : m_focusDist(length(forward)), m_pos(pos), m_up(up), m_forward(forward),
+      m_rideOrientation(0.f, 0.f, 0.f, 1.f), m_eyeHeight(0.5f),
+      m_rideBlend(0.f), m_rideTarget(0.f), m_blendSeconds(1.f) {}
 
 void Camera::rotateAroundFocus(float deltaX, float deltaY) {
   vec3 focus = m_pos + m_forward * m_focusDist;
@@ -78,6 +84,104 @@ vec3 Camera::rotateAround(vec3 const &vec, vec3 const &axis, float radians) {
   return rotated;
 }
 
+// ===== RIDE ===== //
+
+namespace {
+
+// The orientations are glm (x, y, z, w) quaternions, the rotation math is
+// Quat4f's
+Quat4f toQuat4f(vec4 const &q) { return Quat4f(q.w, q.x, q.y, q.z); }
+
+vec4 toVec4(Quat4f const &q) {
+  return vec4(q.im().x(), q.im().y(), q.im().z(), q.re());
+}
+
+vec3 toVec3(Vec3f const &v) { return vec3(v.x(), v.y(), v.z()); }
+
+// View matrix of a camera at eye whose axes are the columns of the rotation
+// q (x, y, z, w): the transposed rotation and the eye moved to the origin.
+// A unit q gives orthonormal axes, nothing needs normalizing.
+mat4 viewFromPose(vec3 const &eye, vec4 const &q) {
+  Quat4f rotation = toQuat4f(q);
+  vec3 right = toVec3(rotation.xAxis());
+  vec3 up = toVec3(rotation.yAxis());
+  vec3 back = toVec3(rotation.zAxis());
+
+  mat4 view(1.f);
+  view[0] = vec4(right.x, up.x, back.x, 0.f);
+  view[1] = vec4(right.y, up.y, back.y, 0.f);
+  view[2] = vec4(right.z, up.z, back.z, 0.f);
+  view[3] = vec4(-dot(right, eye), -dot(up, eye), -dot(back, eye), 1.f);
+  return view;
+}
+
+// Rotation (x, y, z, w) of the orthonormal axes in the rows of a view
+// matrix (glm is column major: view[column][row])
+vec4 orientationOfView(mat4 const &view) {
+  Vec3f right(view[0][0], view[1][0], view[2][0]);
+  Vec3f up(view[0][1], view[1][1], view[2][1]);
+  Vec3f back(view[0][2], view[1][2], view[2][2]);
+  return toVec4(rotationFromAxes(right, up, back));
+}
+
+} // namespace
+
+void Camera::setRidePose(vec3 const &position, vec4 const &orientation) {
+  m_ridePosition = position;
+  m_rideOrientation = orientation;
+}
+
+void Camera::setEyeHeight(float eyeHeight) { m_eyeHeight = eyeHeight; }
+
+void Camera::startRide(float blendSeconds) {
+  m_rideTarget = 1.f;
+  m_blendSeconds = blendSeconds;
+  if (blendSeconds <= 0.f)
+    m_rideBlend = 1.f;
+}
+
+void Camera::stopRide(float blendSeconds) {
+  m_rideTarget = 0.f;
+  m_blendSeconds = blendSeconds;
+  if (blendSeconds <= 0.f)
+    m_rideBlend = 0.f;
+}
+
+void Camera::update(float seconds) {
+  float step = (m_blendSeconds > 0.f) ? seconds / m_blendSeconds : 1.f;
+  if (m_rideBlend < m_rideTarget)
+    m_rideBlend = std::min(m_rideBlend + step, m_rideTarget);
+  else
+    m_rideBlend = std::max(m_rideBlend - step, m_rideTarget);
+}
+
+bool Camera::riding() const { return m_rideBlend > 0.f; }
+
+// eased in and out, so the camera neither jumps into motion nor stops dead
+float Camera::rideWeight() const {
+  return m_rideBlend * m_rideBlend * (3.f - 2.f * m_rideBlend);
+}
+
+mat4 Camera::viewMatrix() const {
+  float weight = rideWeight();
+  if (weight <= 0.f)
+    return lookatMatrix();
+
+  vec4 const &q = m_rideOrientation;
+  vec3 up = toVec3(toQuat4f(q).yAxis());
+  vec3 eye = m_ridePosition + up * m_eyeHeight;
+  if (weight >= 1.f)
+    return viewFromPose(eye, q);
+
+  // between the two poses: position linearly, orientation by normalized
+  // lerp along the shorter arc
+  vec4 freeOrientation = orientationOfView(lookatMatrix());
+  vec4 target = (dot(freeOrientation, q) < 0.f) ? -q : q;
+  vec4 orientation = normalize(mix(freeOrientation, target, weight));
+
+  return viewFromPose(mix(m_pos, eye, weight), orientation);
+}
+
 float Camera::focusDistance() const { return m_focusDist; }
 vec3 const &Camera::position() const { return m_pos; }
 vec3 const &Camera::forward() const { return m_forward; }
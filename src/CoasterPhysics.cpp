@@ -0,0 +1,282 @@
+/**
+ * File:	CoasterPhysics.cpp
+ */
+
+#include "CoasterPhysics.h"
+#include "ArcLengthTable.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define COASTER_PHYSICS_SSE
+#endif
+
+CoasterSimulation::CoasterSimulation() : m_spacing(1.f), m_length(0.f) {}
+
+void CoasterSimulation::setTrack(ArcLengthTable const &track,
+                                 float sampleSpacing) {
+  clearTrains();
+  m_heights.clear();
+  m_length = track.totalLength();
+  m_spacing = sampleSpacing;
+
+  if (track.empty() || m_length <= 0.f || sampleSpacing <= 0.f)
+    return;
+
+  sampleTrack(track, 0);
+}
+
+void CoasterSimulation::updateTrack(ArcLengthTable const &track,
+                                    float fromDistance) {
+  m_length = track.totalLength();
+  if (track.empty() || m_length <= 0.f || m_heights.empty()) {
+    m_heights.clear();
+    return;
+  }
+
+  std::size_t first =
+      static_cast<std::size_t>(std::max(fromDistance, 0.f) / m_spacing);
+  sampleTrack(track, std::min(first, m_heights.size()));
+
+  for (std::size_t i = 0; i < m_distances.size(); ++i) {
+    float s = std::fmod(m_distances[i], m_length);
+    m_distances[i] = (s < 0.f) ? s + m_length : s;
+  }
+}
+
+// Heights from sample firstSample to the end of the track, the ones before
+// it are kept
+void CoasterSimulation::sampleTrack(ArcLengthTable const &track,
+                                    std::size_t firstSample) {
+  // one extra sample so interpolation never reads past the end
+  std::size_t numSamples =
+      static_cast<std::size_t>(std::ceil(m_length / m_spacing)) + 2;
+  m_heights.resize(numSamples);
+
+  parallelFor(firstSample, numSamples, 4096,
+              [&](std::size_t first, std::size_t last) {
+                ArcLengthCursor cursor;
+                track.seek(std::min(first * m_spacing, m_length), cursor);
+                for (std::size_t k = first; k < last; ++k) {
+                  float s = std::min(k * m_spacing, m_length);
+                  m_heights[k] = track.positionAt(s, cursor).y;
+                }
+              });
+}
+
+float CoasterSimulation::trackLength() const { return m_length; }
+
+float CoasterSimulation::heightAt(float s) const {
+  if (m_heights.empty())
+    return 0.f;
+
+  float x = std::max(s, 0.f) / m_spacing;
+  std::size_t k = std::min(static_cast<std::size_t>(x), m_heights.size() - 2);
+  float f = x - k;
+  return m_heights[k] + (m_heights[k + 1] - m_heights[k]) * f;
+}
+
+float CoasterSimulation::highestPoint() const {
+  if (m_heights.empty())
+    return 0.f;
+
+  std::size_t k = std::max_element(m_heights.begin(), m_heights.end()) -
+                  m_heights.begin();
+  return std::min(k * m_spacing, m_length);
+}
+
+CoasterParameters const &CoasterSimulation::parameters() const {
+  return m_parameters;
+}
+
+void CoasterSimulation::setParameters(CoasterParameters const &parameters) {
+  m_parameters = parameters;
+}
+
+CoasterParameters defaultCoasterParameters(CoasterSimulation const &sim) {
+  float length = sim.trackLength();
+  CoasterParameters parameters;
+  parameters.lift = TrackSection(0.f, sim.highestPoint());
+  parameters.brake = TrackSection(0.9f * length, length);
+  return parameters;
+}
+
+std::size_t CoasterSimulation::addTrain(float s, float speed) {
+  if (m_length > 0.f) {
+    s = std::fmod(s, m_length);
+    s = (s < 0.f) ? s + m_length : s;
+  }
+
+  float h = heightAt(s);
+  m_distances.push_back(s);
+  m_speeds.push_back(speed);
+  m_energyHeights.push_back(h + speed * speed / (2.f * m_parameters.gravity));
+  m_laps.push_back(0);
+  m_currentHeights.push_back(h);
+  return m_distances.size() - 1;
+}
+
+void CoasterSimulation::clearTrains() {
+  m_distances.clear();
+  m_speeds.clear();
+  m_energyHeights.clear();
+  m_laps.clear();
+  m_currentHeights.clear();
+}
+
+std::size_t CoasterSimulation::numTrains() const { return m_distances.size(); }
+
+float CoasterSimulation::distance(std::size_t train) const {
+  return m_distances[train];
+}
+
+float CoasterSimulation::speed(std::size_t train) const {
+  return m_speeds[train];
+}
+
+float CoasterSimulation::energyHeight(std::size_t train) const {
+  return m_energyHeights[train];
+}
+
+int CoasterSimulation::laps(std::size_t train) const { return m_laps[train]; }
+
+std::vector<float> const &CoasterSimulation::distances() const {
+  return m_distances;
+}
+
+std::vector<float> const &CoasterSimulation::speeds() const { return m_speeds; }
+
+void CoasterSimulation::step(float dt) {
+  if (m_heights.empty() || dt <= 0.f)
+    return;
+
+  std::size_t count = numTrains();
+  sampleHeights(0, count);
+
+#ifdef COASTER_PHYSICS_SSE
+  std::size_t vectorEnd = count - count % 4;
+  stepVector(0, vectorEnd, dt);
+  stepScalar(vectorEnd, count, dt);
+#else
+  stepScalar(0, count, dt);
+#endif
+}
+
+// The table lookups are gathers, done up front so the update itself only
+// streams through the train arrays
+void CoasterSimulation::sampleHeights(std::size_t first, std::size_t last) {
+  for (std::size_t i = first; i < last; ++i)
+    m_currentHeights[i] = heightAt(m_distances[i]);
+}
+
+// Reference implementation, stepVector() must give the same results
+void CoasterSimulation::stepScalar(std::size_t first, std::size_t last,
+                                   float dt) {
+  CoasterParameters const &p = m_parameters;
+  float inv2g = 1.f / (2.f * p.gravity);
+  float minSpeed2 = p.minSpeed * p.minSpeed;
+
+  for (std::size_t i = first; i < last; ++i) {
+    float s = m_distances[i];
+    float h = m_currentHeights[i];
+    float H = m_energyHeights[i];
+    float v;
+
+    if (!p.lift.empty() && p.lift.contains(s)) {
+      v = p.chainSpeed;
+      H = h + v * v * inv2g;
+    } else {
+      v = std::sqrt(std::max(2.f * p.gravity * (H - h), minSpeed2));
+      if (!p.brake.empty() && p.brake.contains(s) && v > p.brakeSpeed) {
+        v = std::max(v - p.brakeDeceleration * dt, p.brakeSpeed);
+        H = h + v * v * inv2g;
+      }
+    }
+
+    s += v * dt;
+    if (s >= m_length) {
+      s -= m_length;
+      ++m_laps[i];
+    }
+
+    m_distances[i] = s;
+    m_speeds[i] = v;
+    m_energyHeights[i] = H;
+  }
+}
+
+#ifdef COASTER_PHYSICS_SSE
+namespace {
+
+inline __m128 select(__m128 mask, __m128 a, __m128 b) {
+  return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+// Lanes of s inside section, all false for an empty section
+inline __m128 sectionMask(TrackSection const &section, __m128 s) {
+  if (section.empty())
+    return _mm_setzero_ps();
+
+  __m128 afterBegin = _mm_cmpge_ps(s, _mm_set1_ps(section.begin));
+  __m128 beforeEnd = _mm_cmplt_ps(s, _mm_set1_ps(section.end));
+  return section.wraps() ? _mm_or_ps(afterBegin, beforeEnd)
+                         : _mm_and_ps(afterBegin, beforeEnd);
+}
+
+} // namespace
+#endif
+
+void CoasterSimulation::stepVector(std::size_t first, std::size_t last,
+                                   float dt) {
+#ifdef COASTER_PHYSICS_SSE
+  CoasterParameters const &p = m_parameters;
+
+  const __m128 twoG = _mm_set1_ps(2.f * p.gravity);
+  const __m128 inv2g = _mm_set1_ps(1.f / (2.f * p.gravity));
+  const __m128 minSpeed2 = _mm_set1_ps(p.minSpeed * p.minSpeed);
+  const __m128 chainSpeed = _mm_set1_ps(p.chainSpeed);
+  const __m128 brakeSpeed = _mm_set1_ps(p.brakeSpeed);
+  const __m128 brakeStep = _mm_set1_ps(p.brakeDeceleration * dt);
+  const __m128 vdt = _mm_set1_ps(dt);
+  const __m128 length = _mm_set1_ps(m_length);
+
+  for (std::size_t i = first; i < last; i += 4) {
+    __m128 s = _mm_loadu_ps(&m_distances[i]);
+    __m128 h = _mm_loadu_ps(&m_currentHeights[i]);
+    __m128 H = _mm_loadu_ps(&m_energyHeights[i]);
+
+    __m128 onLift = sectionMask(p.lift, s);
+    __m128 onBrake = _mm_andnot_ps(onLift, sectionMask(p.brake, s));
+
+    __m128 v = _mm_sqrt_ps(
+        _mm_max_ps(_mm_mul_ps(twoG, _mm_sub_ps(H, h)), minSpeed2));
+
+    __m128 braking = _mm_and_ps(onBrake, _mm_cmpgt_ps(v, brakeSpeed));
+    v = select(braking, _mm_max_ps(_mm_sub_ps(v, brakeStep), brakeSpeed), v);
+    v = select(onLift, chainSpeed, v);
+
+    // lift and brake set the energy to the speed they leave the train at
+    __m128 resetEnergy = _mm_or_ps(onLift, braking);
+    H = select(resetEnergy, _mm_add_ps(h, _mm_mul_ps(_mm_mul_ps(v, v), inv2g)),
+               H);
+
+    s = _mm_add_ps(s, _mm_mul_ps(v, vdt));
+    __m128 wrapped = _mm_cmpge_ps(s, length);
+    s = _mm_sub_ps(s, _mm_and_ps(wrapped, length));
+
+    // wrapped lanes are all ones, i.e. -1 as an integer
+    __m128i laps = _mm_loadu_si128(reinterpret_cast<__m128i *>(&m_laps[i]));
+    laps = _mm_sub_epi32(laps, _mm_castps_si128(wrapped));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(&m_laps[i]), laps);
+
+    _mm_storeu_ps(&m_distances[i], s);
+    _mm_storeu_ps(&m_speeds[i], v);
+    _mm_storeu_ps(&m_energyHeights[i], H);
+  }
+#else
+  stepScalar(first, last, dt);
+#endif
+}
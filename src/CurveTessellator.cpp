@@ -0,0 +1,237 @@
+/**
+ * File:	CurveTessellator.cpp
+ */
+
+#include "CurveTessellator.h"
+#include "BezierCurve.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+using glm::vec3;
+
+CubicCoefficients bezierCoefficients(vec3 const &p0, vec3 const &p1,
+                                     vec3 const &p2, vec3 const &p3) {
+  CubicCoefficients coeff;
+  coeff.a = -p0 + 3.f * p1 - 3.f * p2 + p3;
+  coeff.b = 3.f * p0 - 6.f * p1 + 3.f * p2;
+  coeff.c = -3.f * p0 + 3.f * p1;
+  coeff.d = p0;
+  return coeff;
+}
+
+std::size_t tessellatedSize(std::size_t numControlPoints,
+                            int samplesPerSegment) {
+  int numSegments = numBezierSegments(numControlPoints);
+  if (numSegments == 0)
+    return 0;
+
+  samplesPerSegment = std::max(samplesPerSegment, 1);
+  return static_cast<std::size_t>(numSegments) * samplesPerSegment + 1;
+}
+
+// Writes the samplesPerSegment vertices of the segment starting at p
+static void tessellateSegment(vec3 const *p, int samplesPerSegment,
+                              vec3 *dst) {
+  float h = 1.f / samplesPerSegment;
+  float h2 = h * h;
+  float h3 = h2 * h;
+
+  CubicCoefficients coeff = bezierCoefficients(p[0], p[1], p[2], p[3]);
+
+  // P(0) and its first three forward differences for step h
+  vec3 point = coeff.d;
+  vec3 d1 = coeff.a * h3 + coeff.b * h2 + coeff.c * h;
+  vec3 d2 = coeff.a * (6.f * h3) + coeff.b * (2.f * h2);
+  vec3 d3 = coeff.a * (6.f * h3);
+
+  for (int j = 0; j < samplesPerSegment; ++j) {
+    *dst++ = point;
+    point += d1;
+    d1 += d2;
+    d2 += d3;
+  }
+}
+
+std::size_t tessellateCurve(vec3 const *controlPoints,
+                            std::size_t numControlPoints,
+                            int samplesPerSegment, vec3 *out) {
+  int numSegments = numBezierSegments(numControlPoints);
+  if (numSegments == 0)
+    return 0;
+
+  samplesPerSegment = std::max(samplesPerSegment, 1);
+
+  // segment seg writes out[seg * samplesPerSegment, ...), about 4k
+  // vertices per task
+  std::size_t grain = std::max(4096 / samplesPerSegment, 1);
+  parallelFor(0, numSegments, grain, [=](std::size_t first, std::size_t last) {
+    for (std::size_t seg = first; seg < last; ++seg)
+      tessellateSegment(controlPoints + 3 * seg, samplesPerSegment,
+                        out + seg * samplesPerSegment);
+  });
+
+  // exact end point rather than the accumulated one
+  std::size_t numPoints = std::size_t(numSegments) * samplesPerSegment;
+  out[numPoints] = controlPoints[3 * numSegments];
+
+  return numPoints + 1;
+}
+
+void tessellateCurve(std::vector<vec3> const &controlPoints,
+                     int samplesPerSegment, std::vector<vec3> &out) {
+  out.resize(tessellatedSize(controlPoints.size(), samplesPerSegment));
+  if (!out.empty())
+    tessellateCurve(controlPoints.data(), controlPoints.size(),
+                    samplesPerSegment, out.data());
+}
+
+void tessellateCurveSegments(vec3 const *controlPoints,
+                             std::size_t numControlPoints,
+                             int samplesPerSegment, int const *segments,
+                             std::size_t numSegments, vec3 *out) {
+  int numCurveSegments = numBezierSegments(numControlPoints);
+  if (numCurveSegments == 0)
+    return;
+
+  samplesPerSegment = std::max(samplesPerSegment, 1);
+
+  std::size_t grain = std::max(4096 / samplesPerSegment, 1);
+  parallelFor(0, numSegments, grain, [=](std::size_t first, std::size_t last) {
+    for (std::size_t i = first; i < last; ++i) {
+      std::size_t seg = segments[i];
+      tessellateSegment(controlPoints + 3 * seg, samplesPerSegment,
+                        out + seg * samplesPerSegment);
+
+      if (seg + 1 == std::size_t(numCurveSegments))
+        out[(seg + 1) * samplesPerSegment] = controlPoints[3 * (seg + 1)];
+    }
+  });
+}
+
+// ==== ADAPTIVE ============================================================//
+
+TessellationStats::TessellationStats()
+    : numVertices(0), numLines(0), maxDepth(0), numForced(0), maxError(0.f),
+      meanError(0.f) {}
+
+std::ostream &operator<<(std::ostream &out, TessellationStats const &stats) {
+  return out << "vertices: " << stats.numVertices
+             << " lines: " << stats.numLines
+             << " max depth: " << stats.maxDepth
+             << " forced: " << stats.numForced
+             << " max error: " << stats.maxError
+             << " mean error: " << stats.meanError;
+}
+
+static float distanceToSegment(vec3 const &p, vec3 const &a, vec3 const &b) {
+  vec3 ab = b - a;
+  float lengthSq = glm::dot(ab, ab);
+  if (lengthSq <= 0.f)
+    return glm::length(p - a);
+
+  float t = glm::clamp(glm::dot(p - a, ab) / lengthSq, 0.f, 1.f);
+  return glm::length(p - (a + ab * t));
+}
+
+float chordalError(vec3 const &p0, vec3 const &p1, vec3 const &p2,
+                   vec3 const &p3) {
+  return std::max(distanceToSegment(p1, p0, p3),
+                  distanceToSegment(p2, p0, p3));
+}
+
+namespace {
+
+struct AdaptiveTessellator {
+  float tolerance;
+  int maxDepth;
+  std::vector<vec3> &out;
+  TessellationStats &stats;
+  double errorSum;
+
+  // Emits p0, p3 is the first vertex of the next piece
+  void subdivide(vec3 const &p0, vec3 const &p1, vec3 const &p2,
+                 vec3 const &p3, int depth) {
+    float error = chordalError(p0, p1, p2, p3);
+
+    if (error <= tolerance || depth >= maxDepth) {
+      if (error > tolerance)
+        ++stats.numForced;
+
+      out.push_back(p0);
+      stats.maxDepth = std::max(stats.maxDepth, depth);
+      stats.maxError = std::max(stats.maxError, error);
+      errorSum += error;
+      return;
+    }
+
+    // de Casteljau split at t = 0.5
+    vec3 p01 = (p0 + p1) * 0.5f;
+    vec3 p12 = (p1 + p2) * 0.5f;
+    vec3 p23 = (p2 + p3) * 0.5f;
+    vec3 p012 = (p01 + p12) * 0.5f;
+    vec3 p123 = (p12 + p23) * 0.5f;
+    vec3 mid = (p012 + p123) * 0.5f;
+
+    subdivide(p0, p01, p012, mid, depth + 1);
+    subdivide(mid, p123, p23, p3, depth + 1);
+  }
+};
+
+} // namespace
+
+TessellationStats tessellateCurveAdaptive(std::vector<vec3> const &controlPoints,
+                                          float tolerance,
+                                          std::vector<vec3> &out,
+                                          int maxDepth) {
+  TessellationStats stats;
+  out.clear();
+
+  int numSegments = numBezierSegments(controlPoints.size());
+  if (numSegments == 0)
+    return stats;
+
+  // Each task subdivides its segments into its own buffer, the buffers are
+  // then joined in segment order
+  const std::size_t SEGMENTS_PER_TASK = 32;
+  struct TaskResult {
+    std::vector<vec3> vertices;
+    TessellationStats stats;
+    double errorSum;
+  };
+  std::vector<TaskResult> results((numSegments + SEGMENTS_PER_TASK - 1) /
+                                  SEGMENTS_PER_TASK);
+
+  parallelFor(0, numSegments, SEGMENTS_PER_TASK,
+              [&](std::size_t first, std::size_t last) {
+                TaskResult &result = results[first / SEGMENTS_PER_TASK];
+                AdaptiveTessellator tessellator = {
+                    tolerance, maxDepth, result.vertices, result.stats, 0.0};
+
+                for (std::size_t seg = first; seg < last; ++seg) {
+                  vec3 const *p = controlPoints.data() + 3 * seg;
+                  tessellator.subdivide(p[0], p[1], p[2], p[3], 0);
+                }
+                result.errorSum = tessellator.errorSum;
+              });
+
+  std::size_t numVertices = 1;
+  for (TaskResult const &result : results)
+    numVertices += result.vertices.size();
+  out.reserve(numVertices);
+
+  double errorSum = 0.0;
+  for (TaskResult const &result : results) {
+    out.insert(out.end(), result.vertices.begin(), result.vertices.end());
+    stats.maxDepth = std::max(stats.maxDepth, result.stats.maxDepth);
+    stats.numForced += result.stats.numForced;
+    stats.maxError = std::max(stats.maxError, result.stats.maxError);
+    errorSum += result.errorSum;
+  }
+  out.push_back(controlPoints[3 * numSegments]);
+
+  stats.numVertices = out.size();
+  stats.numLines = out.size() - 1;
+  stats.meanError = static_cast<float>(errorSum / stats.numLines);
+  return stats;
+}
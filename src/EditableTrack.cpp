@@ -0,0 +1,158 @@
+/**
+ * File:	EditableTrack.cpp
+ */
+
+#include "EditableTrack.h"
+#include "BezierCurve.h"
+#include "CurveTessellator.h"
+#include "Trace.h"
+
+#include <algorithm>
+
+using glm::vec3;
+
+EditableTrack::EditableTrack(int tessellationSamples, int arcLengthSamples)
+    : m_tessellationSamples(std::max(tessellationSamples, 0)),
+      m_arcLengthSamples(std::max(arcLengthSamples, 0)) {}
+
+void EditableTrack::reset(std::vector<vec3> const &controlPoints) {
+  TraceScope scope("EditableTrack::reset", "track");
+
+  assignControlPoints(controlPoints);
+
+  m_arcLengthTable.clear();
+  m_frames.clear();
+  if (m_arcLengthSamples > 0) {
+    m_arcLengthTable.build(m_controlPoints, m_arcLengthSamples);
+    m_frames.build(m_arcLengthTable);
+  }
+}
+
+void EditableTrack::reset(std::vector<vec3> const &controlPoints,
+                          ArcLengthTable const &table) {
+  bool matches = m_arcLengthSamples > 0 &&
+                 table.samplesPerSegment() == m_arcLengthSamples &&
+                 table.numSegments() == numBezierSegments(controlPoints.size());
+  if (!matches) {
+    reset(controlPoints);
+    return;
+  }
+
+  TraceScope scope("EditableTrack::reset", "track");
+  assignControlPoints(controlPoints);
+  m_arcLengthTable = table;
+  m_frames.build(m_arcLengthTable);
+}
+
+// Everything but the arc length table
+void EditableTrack::assignControlPoints(std::vector<vec3> const &controlPoints) {
+  m_controlPoints = controlPoints;
+
+  m_vertices.clear();
+  if (m_tessellationSamples > 0)
+    tessellateCurve(m_controlPoints, m_tessellationSamples, m_vertices);
+
+  m_isDirty.assign(numSegments(), 0);
+  m_dirtySegments.clear();
+  m_updatedSegments.clear();
+  m_updatedVertices.clear();
+}
+
+int EditableTrack::numSegments() const {
+  return numBezierSegments(m_controlPoints.size());
+}
+
+std::vector<vec3> const &EditableTrack::controlPoints() const {
+  return m_controlPoints;
+}
+
+std::vector<vec3> const &EditableTrack::vertices() const { return m_vertices; }
+
+ArcLengthTable const &EditableTrack::arcLengthTable() const {
+  return m_arcLengthTable;
+}
+
+RotationMinimizingFrames const &EditableTrack::frames() const {
+  return m_frames;
+}
+
+// Point 3i starts segment i and ends segment i - 1, the two points in
+// between belong to segment i only
+void EditableTrack::setControlPoint(std::size_t index, vec3 const &position) {
+  if (index >= m_controlPoints.size())
+    return;
+
+  m_controlPoints[index] = position;
+
+  int segment = int(index / 3);
+  if (segment < numSegments())
+    markDirty(segment);
+  if (index % 3 == 0 && segment > 0)
+    markDirty(segment - 1);
+}
+
+void EditableTrack::apply(std::vector<TrackEdit> const &edits) {
+  for (TrackEdit const &edit : edits)
+    setControlPoint(edit.index, edit.position);
+}
+
+bool EditableTrack::dirty() const { return !m_dirtySegments.empty(); }
+
+void EditableTrack::markDirty(int segment) {
+  if (m_isDirty[segment])
+    return;
+
+  m_isDirty[segment] = 1;
+  m_dirtySegments.push_back(segment);
+}
+
+bool EditableTrack::update() {
+  TraceScope scope("EditableTrack::update", "track");
+
+  m_updatedSegments.clear();
+  m_updatedVertices.clear();
+  if (m_dirtySegments.empty())
+    return false;
+
+  std::sort(m_dirtySegments.begin(), m_dirtySegments.end());
+  m_updatedSegments.swap(m_dirtySegments);
+  for (int segment : m_updatedSegments)
+    m_isDirty[segment] = 0;
+
+  if (m_tessellationSamples > 0) {
+    tessellateCurveSegments(m_controlPoints.data(), m_controlPoints.size(),
+                            m_tessellationSamples, m_updatedSegments.data(),
+                            m_updatedSegments.size(), m_vertices.data());
+
+    // consecutive segments are one run, the last one includes the end point
+    std::size_t n = m_tessellationSamples;
+    int last = numSegments() - 1;
+    for (std::size_t i = 0; i < m_updatedSegments.size();) {
+      std::size_t j = i + 1;
+      while (j < m_updatedSegments.size() &&
+             m_updatedSegments[j] == m_updatedSegments[j - 1] + 1)
+        ++j;
+
+      VertexRange range;
+      range.first = m_updatedSegments[i] * n;
+      range.count = (j - i) * n + (m_updatedSegments[j - 1] == last ? 1 : 0);
+      m_updatedVertices.push_back(range);
+      i = j;
+    }
+  }
+
+  if (!m_arcLengthTable.empty()) {
+    m_arcLengthTable.update(m_controlPoints, m_updatedSegments);
+    m_frames.update(m_arcLengthTable, m_updatedSegments);
+  }
+
+  return true;
+}
+
+std::vector<int> const &EditableTrack::updatedSegments() const {
+  return m_updatedSegments;
+}
+
+std::vector<VertexRange> const &EditableTrack::updatedVertices() const {
+  return m_updatedVertices;
+}
@@ -0,0 +1,74 @@
+/**
+ * File:	FixedStepScheduler.cpp
+ */
+
+#include "FixedStepScheduler.h"
+
+#include <algorithm>
+#include <cmath>
+
+FixedStepScheduler::FixedStepScheduler(double stepSeconds,
+                                       int maxStepsPerUpdate)
+    : m_stepSeconds(stepSeconds), m_maxStepsPerUpdate(maxStepsPerUpdate),
+      m_timeScale(1.0) {
+  reset();
+}
+
+int FixedStepScheduler::advance(double realSeconds) {
+  if (realSeconds > 0.0)
+    m_accumulator += realSeconds * m_timeScale;
+
+  double due = std::floor(m_accumulator / m_stepSeconds);
+  int steps = static_cast<int>(std::min(due, double(m_maxStepsPerUpdate)));
+
+  m_accumulator -= steps * m_stepSeconds;
+  if (due > steps) {
+    // over the cap, keep only the fraction of a step for interpolation
+    double fraction = std::fmod(m_accumulator, m_stepSeconds);
+    m_droppedTime += m_accumulator - fraction;
+    m_accumulator = fraction;
+  }
+
+  m_time += steps * m_stepSeconds;
+  m_stepCount += steps;
+  return steps;
+}
+
+void FixedStepScheduler::reset() {
+  m_accumulator = 0.0;
+  m_time = 0.0;
+  m_stepCount = 0;
+  m_droppedTime = 0.0;
+}
+
+double FixedStepScheduler::stepSeconds() const { return m_stepSeconds; }
+
+void FixedStepScheduler::setStepSeconds(double seconds) {
+  if (seconds > 0.0)
+    m_stepSeconds = seconds;
+}
+
+int FixedStepScheduler::maxStepsPerUpdate() const {
+  return m_maxStepsPerUpdate;
+}
+
+void FixedStepScheduler::setMaxStepsPerUpdate(int steps) {
+  m_maxStepsPerUpdate = std::max(steps, 1);
+}
+
+double FixedStepScheduler::timeScale() const { return m_timeScale; }
+
+void FixedStepScheduler::setTimeScale(double scale) {
+  m_timeScale = std::max(scale, 0.0);
+}
+
+double FixedStepScheduler::time() const { return m_time; }
+
+long long FixedStepScheduler::stepCount() const { return m_stepCount; }
+
+double FixedStepScheduler::droppedTime() const { return m_droppedTime; }
+
+float FixedStepScheduler::alpha() const {
+  return static_cast<float>(
+      std::min(m_accumulator / m_stepSeconds, 1.0 - 1e-7));
+}
@@ -0,0 +1,240 @@
+/**
+ * File:	FrameCapture.cpp
+ */
+
+#include "FrameCapture.h"
+#include "Trace.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+
+GLuint makeRenderbuffer(GLenum format, int width, int height, int samples) {
+  GLuint id;
+  glGenRenderbuffers(1, &id);
+  glBindRenderbuffer(GL_RENDERBUFFER, id);
+  if (samples > 1)
+    glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, format, width,
+                                     height);
+  else
+    glRenderbufferStorage(GL_RENDERBUFFER, format, width, height);
+  return id;
+}
+
+bool complete(GLuint framebuffer) {
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+  return glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+}
+
+} // namespace
+
+OffscreenTarget::OffscreenTarget()
+    : m_drawFramebuffer(0), m_readFramebuffer(0), m_width(0), m_height(0),
+      m_samples(0) {}
+
+OffscreenTarget::~OffscreenTarget() { destroy(); }
+
+bool OffscreenTarget::create(int width, int height, int samples) {
+  destroy();
+  if (width <= 0 || height <= 0)
+    return false;
+
+  m_width = width;
+  m_height = height;
+  m_samples = (samples > 1) ? samples : 0;
+
+  GLuint color = makeRenderbuffer(GL_RGBA8, width, height, m_samples);
+  GLuint depth =
+      makeRenderbuffer(GL_DEPTH_COMPONENT24, width, height, m_samples);
+  m_renderbuffers.push_back(color);
+  m_renderbuffers.push_back(depth);
+
+  glGenFramebuffers(1, &m_drawFramebuffer);
+  glBindFramebuffer(GL_FRAMEBUFFER, m_drawFramebuffer);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                            GL_RENDERBUFFER, color);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                            GL_RENDERBUFFER, depth);
+  bool ok = complete(m_drawFramebuffer);
+
+  m_readFramebuffer = m_drawFramebuffer;
+  if (ok && m_samples > 0) {
+    // the samples are resolved into this one, color only
+    GLuint resolved = makeRenderbuffer(GL_RGBA8, width, height, 0);
+    m_renderbuffers.push_back(resolved);
+
+    glGenFramebuffers(1, &m_readFramebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_readFramebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                              GL_RENDERBUFFER, resolved);
+    ok = complete(m_readFramebuffer);
+  }
+
+  glBindRenderbuffer(GL_RENDERBUFFER, 0);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  if (!ok)
+    destroy();
+  return ok;
+}
+
+void OffscreenTarget::destroy() {
+  if (m_readFramebuffer != m_drawFramebuffer)
+    glDeleteFramebuffers(1, &m_readFramebuffer);
+  if (m_drawFramebuffer != 0)
+    glDeleteFramebuffers(1, &m_drawFramebuffer);
+  if (!m_renderbuffers.empty())
+    glDeleteRenderbuffers(GLsizei(m_renderbuffers.size()),
+                          m_renderbuffers.data());
+
+  m_drawFramebuffer = m_readFramebuffer = 0;
+  m_renderbuffers.clear();
+  m_width = m_height = m_samples = 0;
+}
+
+bool OffscreenTarget::isValid() const { return m_drawFramebuffer != 0; }
+
+int OffscreenTarget::width() const { return m_width; }
+
+int OffscreenTarget::height() const { return m_height; }
+
+void OffscreenTarget::bind() const {
+  glBindFramebuffer(GL_FRAMEBUFFER, m_drawFramebuffer);
+  glViewport(0, 0, m_width, m_height);
+}
+
+GLuint OffscreenTarget::resolve() const {
+  if (m_readFramebuffer != m_drawFramebuffer) {
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, m_drawFramebuffer);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_readFramebuffer);
+    glBlitFramebuffer(0, 0, m_width, m_height, 0, 0, m_width, m_height,
+                      GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_drawFramebuffer);
+  }
+  return m_readFramebuffer;
+}
+
+FrameReadback::FrameReadback(int numBuffers)
+    : m_slots(std::max(numBuffers, 1)), m_next(0), m_width(0), m_height(0),
+      m_numCaptured(0), m_stalls(0) {
+  for (Slot &slot : m_slots) {
+    slot.buffer = 0;
+    slot.fence = 0;
+    slot.frame = -1;
+  }
+}
+
+FrameReadback::~FrameReadback() { destroy(); }
+
+bool FrameReadback::create(int width, int height) {
+  destroy();
+  if (width <= 0 || height <= 0)
+    return false;
+
+  m_width = width;
+  m_height = height;
+
+  GLsizeiptr size = GLsizeiptr(3) * width * height;
+  for (Slot &slot : m_slots) {
+    glGenBuffers(1, &slot.buffer);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    glBufferData(GL_PIXEL_PACK_BUFFER, size, NULL, GL_STREAM_READ);
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  return true;
+}
+
+// Frames still in flight are dropped
+void FrameReadback::destroy() {
+  for (Slot &slot : m_slots) {
+    if (slot.fence)
+      glDeleteSync(slot.fence);
+    if (slot.buffer)
+      glDeleteBuffers(1, &slot.buffer);
+    slot.buffer = 0;
+    slot.fence = 0;
+    slot.frame = -1;
+  }
+  m_next = 0;
+  m_width = m_height = 0;
+}
+
+void FrameReadback::capture(OffscreenTarget const &target,
+                            FrameSink const &sink) {
+  capture(target.resolve(), sink);
+}
+
+void FrameReadback::capture(GLuint framebuffer, FrameSink const &sink) {
+  TraceScope scope("FrameReadback::capture", "readback");
+
+  Slot &slot = m_slots[m_next];
+  collect(slot, sink);
+
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+  glPixelStorei(GL_PACK_ALIGNMENT, 1); // rows of 3 * width bytes
+
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+  glReadPixels(0, 0, m_width, m_height, GL_RGB, GL_UNSIGNED_BYTE, (void *)0);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  slot.frame = m_numCaptured++;
+  m_next = (m_next + 1) % m_slots.size();
+}
+
+void FrameReadback::finish(FrameSink const &sink) {
+  for (std::size_t i = 0; i < m_slots.size(); ++i)
+    collect(m_slots[(m_next + i) % m_slots.size()], sink);
+}
+
+void FrameReadback::collect(Slot &slot, FrameSink const &sink) {
+  if (slot.frame < 0)
+    return;
+
+  // normally long done; if not, waiting is all that is left to do
+  GLenum status = glClientWaitSync(slot.fence, 0, 0);
+  if (status == GL_TIMEOUT_EXPIRED) {
+    ++m_stalls;
+    do
+      status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                                1000000000ull);
+    while (status == GL_TIMEOUT_EXPIRED);
+  }
+  glDeleteSync(slot.fence);
+  slot.fence = 0;
+
+  GLsizeiptr size = GLsizeiptr(3) * m_width * m_height;
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+  void const *pixels =
+      glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+  if (pixels)
+    sink(slot.frame, static_cast<unsigned char const *>(pixels), m_width,
+         m_height);
+  glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  slot.frame = -1;
+}
+
+long long FrameReadback::numCaptured() const { return m_numCaptured; }
+
+long long FrameReadback::stalls() const { return m_stalls; }
+
+bool writePPM(std::string const &fileName, unsigned char const *rgb,
+              int width, int height) {
+  TraceScope scope("writePPM", "output");
+
+  FILE *file = std::fopen(fileName.c_str(), "wb");
+  if (!file)
+    return false;
+
+  std::fprintf(file, "P6\n%d %d\n255\n", width, height);
+
+  // top row first
+  std::size_t rowBytes = std::size_t(3) * width;
+  bool ok = true;
+  for (int y = height - 1; y >= 0 && ok; --y)
+    ok = std::fwrite(rgb + y * rowBytes, 1, rowBytes, file) == rowBytes;
+
+  return std::fclose(file) == 0 && ok;
+}
@@ -0,0 +1,97 @@
+/**
+ * File:	GpuTimer.cpp
+ */
+
+#include "GpuTimer.h"
+
+#include <algorithm>
+
+GpuTimer::GpuTimer(Profiler &profiler, int frameLatency)
+    : m_profiler(profiler), m_frames(std::max(frameLatency, 1)), m_current(0),
+      m_started(false), m_firstFrame(0), m_open(false), m_dropped(0) {
+  for (Frame &frame : m_frames)
+    frame.number = 0;
+}
+
+void GpuTimer::beginFrame() {
+  if (m_open)
+    end();
+
+  unsigned long long number = m_profiler.frame();
+  if (!m_started) {
+    m_started = true;
+    m_firstFrame = number;
+  }
+  m_current = std::size_t(number % m_frames.size());
+
+  Frame &frame = m_frames[m_current];
+  collect(frame);
+  frame.number = number;
+}
+
+// Never waits: a result that is not available yet is dropped
+void GpuTimer::collect(Frame &frame) {
+  bool first = frame.number == m_firstFrame;
+  for (Query const &query : frame.issued) {
+    GLint available = 0;
+    glGetQueryObjectiv(query.id, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) {
+      ++m_dropped;
+      continue;
+    }
+
+    GLuint64 nanoseconds = 0;
+    glGetQueryObjectui64v(query.id, GL_QUERY_RESULT, &nanoseconds);
+    if (!first)
+      m_profiler.record(query.section, double(nanoseconds) * 1e-6,
+                        frame.number);
+  }
+  frame.issued.clear();
+}
+
+bool GpuTimer::begin(int section) {
+  if (m_open)
+    return false;
+
+  Frame &frame = m_frames[m_current];
+  if (frame.issued.size() == frame.pool.size()) {
+    GLuint id;
+    glGenQueries(1, &id);
+    frame.pool.push_back(id);
+  }
+
+  Query query = {frame.pool[frame.issued.size()], section};
+  frame.issued.push_back(query);
+
+  glBeginQuery(GL_TIME_ELAPSED, query.id);
+  m_open = true;
+  return true;
+}
+
+void GpuTimer::end() {
+  if (!m_open)
+    return;
+
+  glEndQuery(GL_TIME_ELAPSED);
+  m_open = false;
+}
+
+unsigned long long GpuTimer::dropped() const { return m_dropped; }
+
+void GpuTimer::destroy() {
+  end();
+  for (Frame &frame : m_frames) {
+    if (!frame.pool.empty())
+      glDeleteQueries(GLsizei(frame.pool.size()), frame.pool.data());
+    frame.pool.clear();
+    frame.issued.clear();
+  }
+}
+
+GpuScope::GpuScope(GpuTimer &timer, int section)
+    : m_timer(timer), m_began(timer.begin(section)) {}
+
+GpuScope::~GpuScope() {
+  if (m_began)
+    m_timer.end();
+}
@@ -12,126 +12,100 @@
 
 #include "Mat4f.h"
 
-// ====== CONSTRUCTORS (MOVE/COPY) / DESTRUCTORS ============================//
-Mat4f::Mat4f() {
-  Mat4fHandle tmp(new ARRAY_16f);
-  m_ptr = std::move(tmp); // take ownership
-}
-
-Mat4f::Mat4f(float t) {
-  Mat4fHandle tmp(new ARRAY_16f);
-  tmp->fill(t);
-  m_ptr = std::move(tmp); // take ownership
-}
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#endif
 
+// ====== CONSTRUCTORS (MOVE/COPY) / DESTRUCTORS ============================//
 Mat4f::Mat4f(std::initializer_list<float> list) {
   assert(list.size() == NUM_ELEM);
-  Mat4fHandle tmp(new ARRAY_16f);
-  std::copy_n(list.begin(),  // source
-              NUM_ELEM,      // number of copies
-              tmp->begin()); // destination
-
-  m_ptr = std::move(tmp); // take ownership
-}
-
-Mat4f::Mat4f(Mat4f &&moved) {
-  m_ptr = std::move(moved.m_ptr); // take ownership
-}
-
-Mat4f::Mat4f(const Mat4f &copied) {
-  Mat4fHandle tmp(new ARRAY_16f);
-  std::copy_n(copied.begin(), // source
-              NUM_ELEM,       // number of copies
-              tmp->begin());  // destination
-
-  m_ptr = std::move(tmp); // take ownership
+  std::copy_n(list.begin(),    // source
+              NUM_ELEM,        // number of copies
+              m_data.begin()); // destination
 }
-
-Mat4f::~Mat4f() {}
 // ==========================================================================//
 
 // =========== OPERATORS ====================================================//
 
-Mat4f &Mat4f::operator=(const Mat4f &copied) {
-  if (this != &copied) {
-    Mat4f tmp(copied);
-    *this = std::move(tmp);
-  }
-  return *this;
-}
-
-Mat4f &Mat4f::operator=(Mat4f &&moved) {
-  m_ptr = std::move(moved.m_ptr);
-  return *this;
-}
-
-float &Mat4f::operator()(int row, int column) {
-  assert(isValidDimIndex(row) && isValidDimIndex(column));
-  return m_ptr->at(row * DIM + column);
-}
-
-float Mat4f::operator()(int row, int column) const {
-  assert(isValidDimIndex(row) && isValidDimIndex(column));
-  return m_ptr->at(row * DIM + column);
-}
-
-float &Mat4f::operator[](int element) {
-  assert(isValidElementIndex(element));
-  return m_ptr->at(element);
-}
-
-float Mat4f::operator[](int element) const {
-  assert(isValidElementIndex(element));
-  return m_ptr->at(element);
-}
-
 Mat4f Mat4f::operator+(Mat4f other) const {
-  /* School Computers GCC doesn't support lambda funcs
-  std::transform(	m_ptr->begin(),
-                  m_ptr->end(),
-                  other.m_ptr->begin(),
-                  other.m_ptr->begin(),
-                  []( float left, float right )
-                  {
-                          return left + right;
-                  }
-          );
-  */
-
-  std::transform(m_ptr->begin(), m_ptr->end(), other.m_ptr->begin(),
-                 other.m_ptr->begin(), std::plus<float>());
+  std::transform(m_data.begin(), m_data.end(), other.m_data.begin(),
+                 other.m_data.begin(), std::plus<float>());
   return other;
 }
 
+// Row i of the result is the linear combination of the rows of other,
+// weighted by the elements of row i of this:
+//   result.row(i) = sum_k (*this)(i,k) * other.row(k)
+// so each row is 4 broadcasts and 4 multiply-adds on whole rows.
 Mat4f Mat4f::operator*(const Mat4f &other) const {
   Mat4f result;
 
+  float const *a = data();
+  float const *b = other.data();
+  float *c = result.data();
+
+#if defined(__AVX__)
+  // two result rows per iteration, other's rows duplicated in both lanes
+  __m256 b0 = _mm256_broadcast_ps(reinterpret_cast<__m128 const *>(b + 0));
+  __m256 b1 = _mm256_broadcast_ps(reinterpret_cast<__m128 const *>(b + 4));
+  __m256 b2 = _mm256_broadcast_ps(reinterpret_cast<__m128 const *>(b + 8));
+  __m256 b3 = _mm256_broadcast_ps(reinterpret_cast<__m128 const *>(b + 12));
+
+  for (int i = 0; i < DIM; i += 2) {
+    float const *r0 = a + i * DIM;
+    float const *r1 = r0 + DIM;
+
+    __m256 row = _mm256_mul_ps(_mm256_setr_m128(_mm_set1_ps(r0[0]),
+                                                 _mm_set1_ps(r1[0])),
+                               b0);
+    row = _mm256_add_ps(
+        row, _mm256_mul_ps(
+                 _mm256_setr_m128(_mm_set1_ps(r0[1]), _mm_set1_ps(r1[1])), b1));
+    row = _mm256_add_ps(
+        row, _mm256_mul_ps(
+                 _mm256_setr_m128(_mm_set1_ps(r0[2]), _mm_set1_ps(r1[2])), b2));
+    row = _mm256_add_ps(
+        row, _mm256_mul_ps(
+                 _mm256_setr_m128(_mm_set1_ps(r0[3]), _mm_set1_ps(r1[3])), b3));
+
+    _mm256_storeu_ps(c + i * DIM, row); // only 16 byte alignment guaranteed
+  }
+#elif defined(__SSE__) || defined(_M_X64)
+  __m128 b0 = _mm_load_ps(b + 0);
+  __m128 b1 = _mm_load_ps(b + 4);
+  __m128 b2 = _mm_load_ps(b + 8);
+  __m128 b3 = _mm_load_ps(b + 12);
+
+  for (int i = 0; i < DIM; ++i) {
+    float const *r = a + i * DIM;
+
+    __m128 row = _mm_mul_ps(_mm_set1_ps(r[0]), b0);
+    row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(r[1]), b1));
+    row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(r[2]), b2));
+    row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(r[3]), b3));
+
+    _mm_store_ps(c + i * DIM, row);
+  }
+#else
   float element;
   for (int i = 0; i < DIM; ++i) {
     for (int j = 0; j < DIM; ++j) {
       element = 0;
       for (int k = 0; k < DIM; ++k) {
-        element += (*this)(i, k) * other(k, j);
+        element += a[i * DIM + k] * b[k * DIM + j];
       }
-      result(i, j) = element;
+      c[i * DIM + j] = element;
     }
   }
+#endif
 
   return result;
 }
 
 Mat4f Mat4f::operator*(float scalar) const {
   Mat4f result(*this);
-  /*
-  std::transform( result.m_ptr->begin(),
-                  result.m_ptr->end(),
-                  result.m_ptr->begin(),
-                  [ &scalar ]( float f )
-                  {
-                          return f*scalar;
-                  }
-          );
-  */
 
   for (auto iter = result.begin(); iter != result.end(); ++iter)
     (*iter) *= scalar;
@@ -147,48 +121,29 @@ Mat4f Mat4f::operator*(float scalar) const {
 Mat4f Mat4f::transposed() const {
   Mat4f result;
 
-  result[0] = (*this)[0];
-  result[1] = (*this)[3];
-  result[2] = (*this)[8];
-  result[3] = (*this)[12];
-
-  result[4] = (*this)[1];
-  result[5] = (*this)[5];
-  result[6] = (*this)[9];
-  result[7] = (*this)[13];
+#if defined(__SSE__) || defined(_M_X64)
+  __m128 r0 = _mm_load_ps(data() + 0);
+  __m128 r1 = _mm_load_ps(data() + 4);
+  __m128 r2 = _mm_load_ps(data() + 8);
+  __m128 r3 = _mm_load_ps(data() + 12);
 
-  result[8] = (*this)[2];
-  result[9] = (*this)[6];
-  result[10] = (*this)[10];
-  result[11] = (*this)[14];
+  _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
 
-  result[12] = (*this)[3];
-  result[13] = (*this)[7];
-  result[14] = (*this)[11];
-  result[15] = (*this)[15];
+  _mm_store_ps(result.data() + 0, r0);
+  _mm_store_ps(result.data() + 4, r1);
+  _mm_store_ps(result.data() + 8, r2);
+  _mm_store_ps(result.data() + 12, r3);
+#else
+  for (int i = 0; i < DIM; ++i)
+    for (int j = 0; j < DIM; ++j)
+      result(j, i) = (*this)(i, j);
+#endif
 
   return result;
 }
 
-void Mat4f::fill(float t) { m_ptr->fill(t); }
-
 // ==========================================================================//
 
-float const *Mat4f::data() const { return m_ptr->data(); }
-
-Mat4f::ARRAY_16f::iterator Mat4f::begin() { return m_ptr->begin(); }
-
-Mat4f::ARRAY_16f::iterator Mat4f::end() { return m_ptr->end(); }
-
-Mat4f::ARRAY_16f::const_iterator Mat4f::begin() const { return m_ptr->begin(); }
-
-Mat4f::ARRAY_16f::const_iterator Mat4f::end() const { return m_ptr->end(); }
-
-bool Mat4f::isValidDimIndex(int idx) const { return idx >= 0 && idx < DIM; }
-bool Mat4f::isValidElementIndex(int idx) const {
-  return idx >= 0 && idx < NUM_ELEM;
-}
-
 std::ostream &operator<<(std::ostream &out, const Mat4f &mat) {
   std::ostream_iterator<float> out_it(out, " ");
   std::copy(mat.begin(), mat.end(), out_it);
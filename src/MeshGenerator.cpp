@@ -0,0 +1,187 @@
+/**
+ * File:	MeshGenerator.cpp
+ */
+
+#include "MeshGenerator.h"
+#include "ThreadPool.h"
+#include "Trace.h"
+
+#include <cmath>
+
+using glm::vec2;
+using glm::vec3;
+
+IndexedMesh::IndexedMesh() : topology(MESH_TRIANGLES) {}
+
+void IndexedMesh::clear() {
+  vertices.clear();
+  texCoords.clear();
+  indices.clear();
+}
+
+namespace {
+
+double toRadians(double degree) { return degree * M_PI / 180.0; }
+
+// Latitude bands (rows, and the quads between rows) per parallel task
+const std::size_t ROWS_PER_TASK = 8;
+
+// Indices of a (rings+1) x (columns) grid of vertices, row r at r*columns.
+// When the first or last row is a pole, half of each quad next to it
+// collapses to a point, those triangles are skipped.
+void gridTriangles(int rings, int columns, bool firstRowIsPole,
+                   bool lastRowIsPole, std::vector<std::uint16_t> &indices) {
+  int slices = columns - 1;
+
+  // where each band starts in indices
+  std::vector<std::size_t> bandStart(rings + 1, 0);
+  for (int r = 0; r < rings; ++r) {
+    int triangles = 2 * slices;
+    if (lastRowIsPole && r == rings - 1)
+      triangles -= slices;
+    if (firstRowIsPole && r == 0)
+      triangles -= slices;
+    bandStart[r + 1] = bandStart[r] + 3 * triangles;
+  }
+  indices.resize(bandStart[rings]);
+
+  parallelFor(0, rings, ROWS_PER_TASK, [&](std::size_t first, std::size_t last) {
+    for (int r = int(first); r < int(last); ++r) {
+      std::uint16_t *dst = indices.data() + bandStart[r];
+
+      for (int c = 0; c < slices; ++c) {
+        std::uint16_t v00 = r * columns + c;
+        std::uint16_t v01 = r * columns + c + 1;
+        std::uint16_t v10 = (r + 1) * columns + c;
+        std::uint16_t v11 = (r + 1) * columns + c + 1;
+
+        if (!(lastRowIsPole && r == rings - 1)) {
+          *dst++ = v00;
+          *dst++ = v10;
+          *dst++ = v11;
+        }
+        if (!(firstRowIsPole && r == 0)) {
+          *dst++ = v00;
+          *dst++ = v11;
+          *dst++ = v01;
+        }
+      }
+    }
+  });
+}
+
+void gridStrips(int rings, int columns, std::vector<std::uint16_t> &indices) {
+  // every band but the first starts with a restart index
+  std::size_t bandSize = 2 * columns + 1;
+  indices.resize(rings * bandSize - 1);
+
+  parallelFor(0, rings, ROWS_PER_TASK, [&](std::size_t first, std::size_t last) {
+    for (int r = int(first); r < int(last); ++r) {
+      std::uint16_t *dst = indices.data() + (r == 0 ? 0 : r * bandSize - 1);
+      if (r != 0)
+        *dst++ = MESH_RESTART_INDEX;
+
+      for (int c = 0; c < columns; ++c) {
+        *dst++ = r * columns + c;
+        *dst++ = (r + 1) * columns + c;
+      }
+    }
+  });
+}
+
+} // namespace
+
+void sinCosTable(double startRadians, double stepRadians, int count,
+                 std::vector<float> &sines, std::vector<float> &cosines) {
+  sines.resize(count);
+  cosines.resize(count);
+
+  double s = std::sin(startRadians);
+  double c = std::cos(startRadians);
+  double stepSin = std::sin(stepRadians);
+  double stepCos = std::cos(stepRadians);
+
+  for (int k = 0; k < count; ++k) {
+    sines[k] = static_cast<float>(s);
+    cosines[k] = static_cast<float>(c);
+
+    // (c + is) * (stepCos + i stepSin)
+    double next = c * stepCos - s * stepSin;
+    s = s * stepCos + c * stepSin;
+    c = next;
+  }
+}
+
+bool getSurfaceOfRevolution(std::vector<vec2> const &profile, int slices,
+                            vec3 center, IndexedMesh &mesh,
+                            MeshTopology topology) {
+  mesh.clear();
+  mesh.topology = topology;
+
+  int rings = static_cast<int>(profile.size()) - 1;
+  int columns = slices + 1; // the seam is duplicated for the texture coords
+
+  std::size_t numVertices = profile.size() * std::size_t(columns);
+  if (rings < 1 || slices < 1 || numVertices >= MESH_RESTART_INDEX)
+    return false;
+
+  std::vector<float> sines, cosines;
+  sinCosTable(0.0, 2.0 * M_PI / slices, columns, sines, cosines);
+
+  mesh.vertices.resize(numVertices);
+  mesh.texCoords.resize(numVertices);
+
+  parallelFor(0, rings + 1, ROWS_PER_TASK,
+              [&](std::size_t first, std::size_t last) {
+                for (int r = int(first); r < int(last); ++r) {
+                  float radius = profile[r].x;
+                  float y = profile[r].y + center.y;
+                  float v = 1.f - float(r) / rings;
+
+                  vec3 *verts = mesh.vertices.data() + r * columns;
+                  vec2 *uvs = mesh.texCoords.data() + r * columns;
+
+                  for (int c = 0; c < columns; ++c) {
+                    verts[c] = vec3(radius * cosines[c] + center.x, y,
+                                    radius * sines[c] + center.z);
+                    uvs[c] = vec2(1.f - float(c) / slices, v);
+                  }
+                }
+              });
+
+  if (topology == MESH_TRIANGLE_STRIPS)
+    gridStrips(rings, columns, mesh.indices);
+  else
+    gridTriangles(rings, columns, profile.front().x == 0.f,
+                  profile.back().x == 0.f, mesh.indices);
+
+  return true;
+}
+
+// Profile of a sphere: a half circle from the north to the south pole
+bool getSpherePoints(float radius, vec3 center, IndexedMesh &mesh,
+                     MeshTopology topology, int stepDegrees) {
+  TraceScope scope("getSpherePoints", "mesh");
+
+  if (stepDegrees <= 0) {
+    mesh.clear();
+    return false;
+  }
+
+  int rings = 180 / stepDegrees;
+  int slices = 360 / stepDegrees;
+
+  std::vector<float> sines, cosines;
+  sinCosTable(0.0, toRadians(stepDegrees), rings + 1, sines, cosines);
+
+  std::vector<vec2> profile(rings + 1);
+  for (int r = 0; r <= rings; ++r)
+    profile[r] = vec2(radius * sines[r], radius * cosines[r]);
+
+  // exactly on the axis, so the poles are recognised
+  profile.front().x = 0.f;
+  if (rings * stepDegrees == 180)
+    profile.back().x = 0.f;
+
+  return getSurfaceOfRevolution(profile, slices, center, mesh, topology);
+}
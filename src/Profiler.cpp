@@ -0,0 +1,156 @@
+/**
+ * File:	Profiler.cpp
+ */
+
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <ostream>
+
+namespace {
+
+// Nearest rank percentile of sorted values, p in [0,100]
+double percentile(std::vector<double> const &sorted, double p) {
+  if (sorted.empty())
+    return 0.0;
+  std::size_t rank = std::size_t(std::ceil(p / 100.0 * sorted.size()));
+  return sorted[std::min(std::max<std::size_t>(rank, 1), sorted.size()) - 1];
+}
+
+} // namespace
+
+Profiler::Profiler(std::size_t windowSize)
+    : m_windowSize(std::max<std::size_t>(windowSize, 1)), m_frame(0) {}
+
+int Profiler::section(std::string const &name) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (std::size_t i = 0; i < m_sections.size(); ++i)
+    if (m_sections[i].name == name)
+      return int(i);
+
+  Section section;
+  section.name = name;
+  section.window.resize(m_windowSize);
+  section.next = 0;
+  section.count = 0;
+  m_sections.push_back(section);
+  return int(m_sections.size() - 1);
+}
+
+void Profiler::record(int section, double milliseconds) {
+  record(section, milliseconds, m_frame.load());
+}
+
+void Profiler::record(int section, double milliseconds,
+                      unsigned long long frame) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (section < 0 || section >= int(m_sections.size()))
+    return;
+
+  Section &s = m_sections[section];
+  s.window[s.next] = milliseconds;
+  s.next = (s.next + 1) % m_windowSize;
+  s.count = std::min(s.count + 1, m_windowSize);
+
+  if (m_csv.is_open())
+    m_csv << frame << ",\"" << s.name << "\"," << milliseconds << '\n';
+}
+
+void Profiler::nextFrame() { ++m_frame; }
+
+unsigned long long Profiler::frame() const { return m_frame.load(); }
+
+bool Profiler::openCsv(std::string const &fileName) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_csv.close();
+  m_csv.clear();
+  m_csv.open(fileName.c_str());
+  if (!m_csv.is_open())
+    return false;
+
+  m_csv << "frame,section,milliseconds\n";
+  return true;
+}
+
+void Profiler::closeCsv() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_csv.close();
+}
+
+std::vector<ProfileStats> Profiler::stats() const {
+  std::vector<ProfileStats> result;
+  std::vector<double> sorted;
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (Section const &s : m_sections) {
+    sorted.assign(s.window.begin(), s.window.begin() + s.count);
+    std::sort(sorted.begin(), sorted.end());
+
+    ProfileStats stats;
+    stats.name = s.name;
+    stats.count = s.count;
+    stats.meanMs = 0.0;
+    for (double ms : sorted)
+      stats.meanMs += ms;
+    if (!sorted.empty())
+      stats.meanMs /= sorted.size();
+    stats.medianMs = percentile(sorted, 50.0);
+    stats.p95Ms = percentile(sorted, 95.0);
+    stats.p99Ms = percentile(sorted, 99.0);
+    stats.maxMs = sorted.empty() ? 0.0 : sorted.back();
+    result.push_back(stats);
+  }
+  return result;
+}
+
+void Profiler::report(std::ostream &out) const {
+  std::vector<ProfileStats> all = stats();
+
+  std::size_t width = 8;
+  for (ProfileStats const &s : all)
+    width = std::max(width, s.name.size());
+
+  std::ios::fmtflags flags = out.flags();
+  std::streamsize precision = out.precision();
+
+  out << "---- profile, frame " << frame() << " (ms over the last "
+      << m_windowSize << ") ----\n";
+  out << std::left << std::setw(int(width)) << "section" << std::right
+      << std::setw(10) << "mean" << std::setw(10) << "median" << std::setw(10)
+      << "p95" << std::setw(10) << "p99" << std::setw(10) << "max"
+      << std::setw(8) << "n" << '\n';
+
+  out << std::fixed << std::setprecision(3);
+  for (ProfileStats const &s : all) {
+    if (s.count == 0)
+      continue;
+    out << std::left << std::setw(int(width)) << s.name << std::right
+        << std::setw(10) << s.meanMs << std::setw(10) << s.medianMs
+        << std::setw(10) << s.p95Ms << std::setw(10) << s.p99Ms
+        << std::setw(10) << s.maxMs << std::setw(8) << s.count << '\n';
+  }
+  out.flush();
+
+  out.flags(flags);
+  out.precision(precision);
+}
+
+void Profiler::reset() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (Section &s : m_sections) {
+    s.next = 0;
+    s.count = 0;
+  }
+}
+
+ProfileScope::ProfileScope(Profiler &profiler, int section)
+    : m_profiler(profiler), m_section(section),
+      m_start(std::chrono::steady_clock::now()) {}
+
+ProfileScope::~ProfileScope() {
+  std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::steady_clock::now() - m_start;
+  m_profiler.record(m_section, elapsed.count());
+}
@@ -1,5 +1,6 @@
 #include "Quat4f.h"
 
+#include <cmath>
 #include <limits>
 
 Quat4f slerp(Quat4f const &a, Quat4f const &b, float t) {
@@ -50,6 +51,34 @@ Quat4f slerp(Quat4f const &a, Quat4f const &b, float t) {
   return a * beta + b * alpha;
 }
 
+// From the largest of w, x, y and z, so the division is well conditioned
+Quat4f rotationFromAxes(Vec3f const &x, Vec3f const &y, Vec3f const &z) {
+  // m<row><column>
+  float m00 = x.x(), m01 = y.x(), m02 = z.x();
+  float m10 = x.y(), m11 = y.y(), m12 = z.y();
+  float m20 = x.z(), m21 = y.z(), m22 = z.z();
+
+  float trace = m00 + m11 + m22;
+  if (trace > 0.f) {
+    float s = 2.f * std::sqrt(trace + 1.f);
+    return Quat4f(0.25f * s, (m21 - m12) / s, (m02 - m20) / s,
+                  (m10 - m01) / s);
+  }
+  if (m00 > m11 && m00 > m22) {
+    float s = 2.f * std::sqrt(1.f + m00 - m11 - m22);
+    return Quat4f((m21 - m12) / s, 0.25f * s, (m01 + m10) / s,
+                  (m02 + m20) / s);
+  }
+  if (m11 > m22) {
+    float s = 2.f * std::sqrt(1.f + m11 - m00 - m22);
+    return Quat4f((m02 - m20) / s, (m01 + m10) / s, 0.25f * s,
+                  (m12 + m21) / s);
+  }
+  float s = 2.f * std::sqrt(1.f + m22 - m00 - m11);
+  return Quat4f((m10 - m01) / s, (m02 + m20) / s, (m12 + m21) / s,
+                0.25f * s);
+}
+
 Vec3f rotateAround(Vec3f const &vec, Vec3f const &axis, float radians) {
   radians *= 0.5;
   const float sinAngle = std::sin(radians);
@@ -0,0 +1,262 @@
+/**
+ * File:	RotationMinimizingFrames.cpp
+ */
+
+#include "RotationMinimizingFrames.h"
+#include "BezierCurve.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+
+using glm::vec3;
+
+namespace {
+
+const float EPSILON = 1e-12f;
+
+Vec3f toVec3f(vec3 const &v) { return Vec3f(v.x, v.y, v.z); }
+
+vec3 toVec3(Vec3f const &v) { return vec3(v.x(), v.y(), v.z()); }
+
+// Rotation whose matrix has the columns right, up and -forward
+Quat4f frameQuat(vec3 const &forward, vec3 const &up) {
+  return rotationFromAxes(toVec3f(glm::cross(forward, up)), toVec3f(up),
+                          toVec3f(-forward));
+}
+
+// Rotation by angle about the local forward axis (-z)
+Quat4f rollQuat(float angle) {
+  return Quat4f(std::cos(0.5f * angle), 0.f, 0.f, -std::sin(0.5f * angle));
+}
+
+vec3 upAxis(Quat4f const &q) { return toVec3(q.yAxis()); }
+
+vec3 forwardAxis(Quat4f const &q) { return -toVec3(q.zAxis()); }
+
+// v reflected in the plane through the origin with normal n
+vec3 reflect(vec3 const &v, vec3 const &n) {
+  float nn = glm::dot(n, n);
+  return (nn > EPSILON) ? v - (2.f / nn) * glm::dot(n, v) * n : v;
+}
+
+// up, perpendicular to tangent, turned as little as possible to be
+// perpendicular to newTangent: where segments meet at an angle. Reflecting in
+// the plane normal to tangent leaves up as it is and reverses tangent, so
+// only the second reflection of the pair is needed.
+vec3 carry(vec3 const &up, vec3 const &tangent, vec3 const &newTangent) {
+  return reflect(up, tangent + newTangent);
+}
+
+// Angle about axis that turns a into b, both perpendicular to axis
+float signedAngle(vec3 const &a, vec3 const &b, vec3 const &axis) {
+  return std::atan2(glm::dot(glm::cross(a, b), axis), glm::dot(a, b));
+}
+
+// Up vector for the first frame of a segment: worldUp without its
+// component along the tangent
+vec3 initialUp(vec3 const &tangent, vec3 const &worldUp) {
+  vec3 up = worldUp - glm::dot(worldUp, tangent) * tangent;
+  if (glm::dot(up, up) < 1e-8f) {
+    // going straight up or down, any perpendicular will do
+    vec3 axis = (std::fabs(tangent.x) < 0.9f) ? vec3(1.f, 0.f, 0.f)
+                                              : vec3(0.f, 0.f, 1.f);
+    up = glm::cross(tangent, axis);
+  }
+  return glm::normalize(up);
+}
+
+} // namespace
+
+RotationMinimizingFrames::RotationMinimizingFrames()
+    : m_worldUp(0.f, 1.f, 0.f), m_samplesPerSegment(0), m_closingTwist(0.f),
+      m_length(0.f) {}
+
+void RotationMinimizingFrames::build(ArcLengthTable const &track,
+                                     vec3 const &worldUp) {
+  clear();
+  m_worldUp = glm::normalize(worldUp);
+  if (track.empty())
+    return;
+
+  int numSegments = track.numSegments();
+  m_samplesPerSegment = track.samplesPerSegment() + 1;
+  m_localFrames.resize(track.size());
+  m_rollSteps.resize(numSegments);
+  m_rolls.resize(numSegments);
+
+  std::size_t grain = std::max<std::size_t>(4096 / m_samplesPerSegment, 1);
+  parallelFor(0, numSegments, grain, [&](std::size_t first, std::size_t last) {
+    for (std::size_t seg = first; seg < last; ++seg)
+      computeSegment(track, int(seg));
+  });
+  parallelFor(0, numSegments, 4096, [&](std::size_t first, std::size_t last) {
+    for (std::size_t seg = first; seg < last; ++seg)
+      m_rollSteps[seg] = rollStep(int(seg));
+  });
+
+  accumulateRolls(track, 0);
+}
+
+void RotationMinimizingFrames::update(ArcLengthTable const &track,
+                                      std::vector<int> const &segments) {
+  if (empty() || track.size() != size()) {
+    build(track, m_worldUp);
+    return;
+  }
+  if (segments.empty())
+    return;
+
+  std::size_t grain = std::max<std::size_t>(4096 / m_samplesPerSegment, 1);
+  parallelFor(0, segments.size(), grain,
+              [&](std::size_t first, std::size_t last) {
+                for (std::size_t i = first; i < last; ++i)
+                  computeSegment(track, segments[i]);
+              });
+
+  // each segment's frames meet the ones before and after it
+  int numSegments = int(m_rolls.size());
+  for (int seg : segments) {
+    m_rollSteps[seg] = rollStep(seg);
+    if (seg + 1 < numSegments)
+      m_rollSteps[seg + 1] = rollStep(seg + 1);
+  }
+
+  accumulateRolls(track, segments.front());
+}
+
+void RotationMinimizingFrames::clear() {
+  m_samplesPerSegment = 0;
+  m_localFrames.clear();
+  m_rollSteps.clear();
+  m_rolls.clear();
+  m_closingTwist = 0.f;
+  m_length = 0.f;
+}
+
+bool RotationMinimizingFrames::empty() const { return m_localFrames.empty(); }
+
+std::size_t RotationMinimizingFrames::size() const {
+  return m_localFrames.size();
+}
+
+float RotationMinimizingFrames::closingTwist() const { return m_closingTwist; }
+
+// Double reflection from the segment's first sample on, which starts with
+// the up vector closest to m_worldUp
+void RotationMinimizingFrames::computeSegment(ArcLengthTable const &track,
+                                              int segment) {
+  std::vector<vec3> const &controlPoints = track.controlPoints();
+  std::size_t first = segment * m_samplesPerSegment;
+
+  // where the derivative vanishes (coincident control points) the chord
+  // gives the direction
+  vec3 const *p = &controlPoints[3 * segment];
+  vec3 chord = p[3] - p[0];
+  vec3 previousTangent = (glm::dot(chord, chord) > EPSILON)
+                             ? glm::normalize(chord)
+                             : vec3(0.f, 0.f, -1.f);
+
+  vec3 previousPoint, previousUp;
+  Quat4f previousFrame;
+  for (std::size_t j = 0; j < m_samplesPerSegment; ++j) {
+    float t = track.sampleParameter(first + j).t;
+    vec3 point = calcPoint(p[0], p[1], p[2], p[3], t);
+    vec3 derivative = calcDerivative(p[0], p[1], p[2], p[3], t);
+
+    vec3 tangent = (glm::dot(derivative, derivative) > EPSILON)
+                       ? glm::normalize(derivative)
+                       : previousTangent;
+
+    vec3 up;
+    if (j == 0) {
+      up = initialUp(tangent, m_worldUp);
+    } else {
+      // reflect in the bisector of the two points, then in the plane that
+      // takes the reflected tangent onto the new one
+      vec3 v1 = point - previousPoint;
+      vec3 reflectedUp = reflect(previousUp, v1);
+      vec3 reflectedTangent = reflect(previousTangent, v1);
+      up = reflect(reflectedUp, tangent - reflectedTangent);
+
+      // keep it exactly perpendicular, round off would build up
+      up = glm::normalize(up - glm::dot(up, tangent) * tangent);
+    }
+
+    Quat4f frame = frameQuat(tangent, up);
+    if (j > 0 && frame.re() * previousFrame.re() +
+                         frame.im() * previousFrame.im() <
+                     0.f)
+      frame = -frame; // same hemisphere as its neighbour, for slerp
+    m_localFrames[first + j] = frame;
+
+    previousPoint = point;
+    previousTangent = tangent;
+    previousUp = up;
+    previousFrame = frame;
+  }
+}
+
+// Roll of segment's own frames that continues the frames of the segment
+// before it (also taken without its roll). Rolling a segment about its
+// tangent rolls everything after it by the same angle, so the rolls of the
+// segments are the running sum of these.
+float RotationMinimizingFrames::rollStep(int segment) const {
+  if (segment == 0)
+    return 0.f;
+
+  Quat4f const &end = m_localFrames[segment * m_samplesPerSegment - 1];
+  Quat4f const &start = m_localFrames[segment * m_samplesPerSegment];
+
+  vec3 startTangent = forwardAxis(start);
+  vec3 up = carry(upAxis(end), forwardAxis(end), startTangent);
+  return signedAngle(upAxis(start), up, startTangent);
+}
+
+// Rolls of the segments from firstSegment on, then the closing twist
+void RotationMinimizingFrames::accumulateRolls(ArcLengthTable const &track,
+                                               int firstSegment) {
+  int numSegments = int(m_rolls.size());
+  if (firstSegment == 0)
+    m_rolls[0] = 0.0;
+
+  for (int seg = std::max(firstSegment, 1); seg < numSegments; ++seg)
+    m_rolls[seg] = m_rolls[seg - 1] + m_rollSteps[seg];
+
+  m_length = track.totalLength();
+  m_closingTwist = 0.f;
+
+  std::vector<vec3> const &controlPoints = track.controlPoints();
+  vec3 gap = controlPoints.back() - controlPoints.front();
+  if (glm::dot(gap, gap) < 1e-10f) {
+    Quat4f end = m_localFrames.back() * rollQuat(float(m_rolls.back()));
+    Quat4f const &start = m_localFrames.front();
+
+    vec3 startTangent = forwardAxis(start);
+    vec3 up = carry(upAxis(end), forwardAxis(end), startTangent);
+    m_closingTwist = signedAngle(up, upAxis(start), startTangent);
+  }
+}
+
+// Roll of the segment of sample, plus the closing twist up to distance
+float RotationMinimizingFrames::roll(std::size_t sample, float distance) const {
+  float twist = (m_length > 0.f) ? m_closingTwist * distance / m_length : 0.f;
+  return float(m_rolls[sample / m_samplesPerSegment]) + twist;
+}
+
+Quat4f RotationMinimizingFrames::orientation(std::size_t sample,
+                                             float distance) const {
+  return m_localFrames[sample] * rollQuat(roll(sample, distance));
+}
+
+// Both samples have the same roll, except across the zero length interval
+// between two segments
+Quat4f RotationMinimizingFrames::orientationAt(
+    ArcLengthSample const &sample) const {
+  std::size_t i = sample.index;
+  if (i / m_samplesPerSegment != (i + 1) / m_samplesPerSegment)
+    return orientation(sample.fraction < 0.5f ? i : i + 1, sample.distance);
+
+  return slerp(m_localFrames[i], m_localFrames[i + 1], sample.fraction) *
+         rollQuat(roll(i, sample.distance));
+}
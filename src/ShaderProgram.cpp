@@ -0,0 +1,187 @@
+/**
+ * File:	ShaderProgram.cpp
+ */
+
+#include "ShaderProgram.h"
+#include "ShaderTools.h"
+
+GLuint ShaderProgram::s_boundProgram = 0;
+
+ShaderProgram::ShaderProgram() : m_id(0) {}
+
+ShaderProgram::~ShaderProgram() { destroy(); }
+
+ShaderProgram::ShaderProgram(ShaderProgram &&moved)
+    : m_id(moved.m_id), m_uniforms(std::move(moved.m_uniforms)),
+      m_attributes(std::move(moved.m_attributes)) {
+  moved.m_id = 0;
+}
+
+ShaderProgram &ShaderProgram::operator=(ShaderProgram &&moved) {
+  if (this != &moved) {
+    destroy();
+    m_id = moved.m_id;
+    m_uniforms = std::move(moved.m_uniforms);
+    m_attributes = std::move(moved.m_attributes);
+    moved.m_id = 0;
+  }
+  return *this;
+}
+
+bool ShaderProgram::create(const std::string &vsSource,
+                           const std::string &fsSource) {
+  return adopt(CreateShaderProgram(vsSource, fsSource));
+}
+
+bool ShaderProgram::create(const std::string &vsSource,
+                           const std::string &gsSource,
+                           const std::string &fsSource) {
+  return adopt(CreateShaderProgram(vsSource, gsSource, fsSource));
+}
+
+bool ShaderProgram::adopt(GLuint programID) {
+  destroy();
+
+  m_id = programID;
+  if (m_id != 0)
+    queryVariables();
+
+  return isValid();
+}
+
+void ShaderProgram::destroy() {
+  if (m_id == 0)
+    return;
+
+  if (s_boundProgram == m_id)
+    s_boundProgram = 0;
+
+  glDeleteProgram(m_id);
+  m_id = 0;
+  m_uniforms.clear();
+  m_attributes.clear();
+}
+
+bool ShaderProgram::isValid() const { return m_id != 0; }
+
+GLuint ShaderProgram::id() const { return m_id; }
+
+void ShaderProgram::use() const {
+  if (s_boundProgram != m_id) {
+    glUseProgram(m_id);
+    s_boundProgram = m_id;
+  }
+}
+
+static std::string stripArraySuffix(std::string name) {
+  std::string::size_type bracket = name.find('[');
+  if (bracket != std::string::npos)
+    name.erase(bracket);
+  return name;
+}
+
+void ShaderProgram::queryVariables() {
+  m_uniforms.clear();
+  m_attributes.clear();
+
+  GLint count = 0;
+  GLint maxLength = 0;
+  std::vector<char> name;
+
+  glGetProgramiv(m_id, GL_ACTIVE_UNIFORMS, &count);
+  glGetProgramiv(m_id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+  name.resize(maxLength + 1);
+
+  for (GLint i = 0; i < count; ++i) {
+    Variable var;
+    GLsizei length = 0;
+    glGetActiveUniform(m_id, i, name.size(), &length, &var.size, &var.type,
+                       name.data());
+    var.name = stripArraySuffix(std::string(name.data(), length));
+    // members of uniform blocks have no location, they are set by buffer
+    var.location = glGetUniformLocation(m_id, name.data());
+    m_uniforms.push_back(var);
+  }
+
+  glGetProgramiv(m_id, GL_ACTIVE_ATTRIBUTES, &count);
+  glGetProgramiv(m_id, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &maxLength);
+  name.resize(maxLength + 1);
+
+  for (GLint i = 0; i < count; ++i) {
+    Variable var;
+    GLsizei length = 0;
+    glGetActiveAttrib(m_id, i, name.size(), &length, &var.size, &var.type,
+                      name.data());
+    var.name = stripArraySuffix(std::string(name.data(), length));
+    var.location = glGetAttribLocation(m_id, name.data());
+    m_attributes.push_back(var);
+  }
+}
+
+static GLint findLocation(std::vector<ShaderProgram::Variable> const &vars,
+                          const std::string &name) {
+  for (std::size_t i = 0; i < vars.size(); ++i) {
+    if (vars[i].name == name)
+      return vars[i].location;
+  }
+  return -1;
+}
+
+GLint ShaderProgram::uniformLocation(const std::string &name) const {
+  return findLocation(m_uniforms, name);
+}
+
+GLint ShaderProgram::attributeLocation(const std::string &name) const {
+  return findLocation(m_attributes, name);
+}
+
+bool ShaderProgram::bindUniformBlock(const std::string &name,
+                                     GLuint binding) const {
+  GLuint blockIndex = glGetUniformBlockIndex(m_id, name.c_str());
+  if (blockIndex == GL_INVALID_INDEX)
+    return false;
+
+  glUniformBlockBinding(m_id, blockIndex, binding);
+  return true;
+}
+
+std::vector<ShaderProgram::Variable> const &ShaderProgram::uniforms() const {
+  return m_uniforms;
+}
+
+std::vector<ShaderProgram::Variable> const &
+ShaderProgram::attributes() const {
+  return m_attributes;
+}
+
+void ShaderProgram::setUniform(GLint location, int value) const {
+  use();
+  glUniform1i(location, value);
+}
+
+void ShaderProgram::setUniform(GLint location, float value) const {
+  use();
+  glUniform1f(location, value);
+}
+
+void ShaderProgram::setUniform(GLint location, float x, float y,
+                               float z) const {
+  use();
+  glUniform3f(location, x, y, z);
+}
+
+void ShaderProgram::setUniform(GLint location, glm::vec3 const &value) const {
+  use();
+  glUniform3f(location, value.x, value.y, value.z);
+}
+
+void ShaderProgram::setUniform(GLint location, glm::vec4 const &value) const {
+  use();
+  glUniform4f(location, value.x, value.y, value.z, value.w);
+}
+
+// glm matrices are column major, no transpose
+void ShaderProgram::setUniform(GLint location, glm::mat4 const &value) const {
+  use();
+  glUniformMatrix4fv(location, 1, GL_FALSE, &value[0][0]);
+}
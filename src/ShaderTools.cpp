@@ -23,9 +23,17 @@
  */
 
 #include "ShaderTools.h"
+#include "Trace.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <sstream>
+#include <sys/stat.h>
 
 GLuint CreateShaderProgram(const std::string &vsSource,
                            const std::string &fsSource) {
+  TraceScope scope("CreateShaderProgram", "shaders");
+
   GLuint programID = glCreateProgram();
   GLuint vsID = glCreateShader(GL_VERTEX_SHADER);
   GLuint fsID = glCreateShader(GL_FRAGMENT_SHADER);
@@ -78,12 +86,16 @@ GLuint CreateShaderProgram(const std::string &vsSource,
     return 0; // invalid ID
   }
 
+  bindCameraMatricesBlock(programID);
+
   return programID;
 }
 
 GLuint CreateShaderProgram(const std::string &vsSource,
                            const std::string &gsSource,
                            const std::string &fsSource) {
+  TraceScope scope("CreateShaderProgram", "shaders");
+
   GLuint programID = glCreateProgram();
   GLuint vsID = glCreateShader(GL_VERTEX_SHADER);
   GLuint gsID = glCreateShader(GL_GEOMETRY_SHADER);
@@ -146,9 +158,18 @@ GLuint CreateShaderProgram(const std::string &vsSource,
     return 0; // invalid ID
   }
 
+  bindCameraMatricesBlock(programID);
+
   return programID;
 }
 
+// Programs without the block are left alone
+void bindCameraMatricesBlock(GLuint programID) {
+  GLuint blockIndex = glGetUniformBlockIndex(programID, CAMERA_MATRICES_BLOCK);
+  if (blockIndex != GL_INVALID_INDEX)
+    glUniformBlockBinding(programID, blockIndex, CAMERA_MATRICES_BINDING);
+}
+
 bool checkLinkStatus(GLint programID) {
   GLint result;
   int infoLogLength;
@@ -193,3 +214,207 @@ std::string loadShaderStringfromFile(const std::string &filePath) {
   }
   return shaderCode;
 }
+
+// ==== PROGRAM BINARY CACHE ================================================//
+
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+
+typedef void(APIENTRYP PFNGETPROGRAMBINARY)(GLuint program, GLsizei bufSize,
+                                            GLsizei *length,
+                                            GLenum *binaryFormat,
+                                            void *binary);
+typedef void(APIENTRYP PFNPROGRAMBINARY)(GLuint program, GLenum binaryFormat,
+                                         const void *binary, GLsizei length);
+typedef void(APIENTRYP PFNPROGRAMPARAMETERI)(GLuint program, GLenum pname,
+                                             GLint value);
+
+static PFNGETPROGRAMBINARY getProgramBinary = NULL;
+static PFNPROGRAMBINARY programBinary = NULL;
+static PFNPROGRAMPARAMETERI programParameteri = NULL;
+
+namespace {
+
+// Header of every cache file, followed by `length` bytes of binary
+struct ProgramBinaryHeader {
+  std::uint32_t magic;
+  std::uint32_t version;
+  std::uint32_t binaryFormat;
+  std::uint32_t length;
+};
+
+const std::uint32_t PROGRAM_CACHE_MAGIC = 0x43505351; // "QSPC"
+const std::uint32_t PROGRAM_CACHE_VERSION = 1;
+
+// 64 bit FNV-1a
+std::uint64_t hashString(const std::string &str,
+                         std::uint64_t hash = 14695981039346656037ULL) {
+  for (std::size_t i = 0; i < str.size(); ++i) {
+    hash ^= static_cast<unsigned char>(str[i]);
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+std::string glString(GLenum name) {
+  const GLubyte *str = glGetString(name);
+  return str ? reinterpret_cast<const char *>(str) : "";
+}
+
+std::string cacheFilePath(const std::string &cacheDir,
+                          const std::string &key) {
+  return cacheDir + "/" + key + ".bin";
+}
+
+// Bytes from the read position to the end of file, the position unchanged
+std::streamoff remainingBytes(std::ifstream &file) {
+  std::streampos position = file.tellg();
+  file.seekg(0, std::ios::end);
+  std::streamoff remaining = file.tellg() - position;
+  file.seekg(position);
+  return remaining;
+}
+
+GLuint loadCachedProgram(const std::string &path) {
+  std::ifstream file(path.c_str(), std::ios::in | std::ios::binary);
+  if (!file)
+    return 0; // not cached yet
+
+  ProgramBinaryHeader header;
+  std::vector<char> binary;
+  bool valid = false;
+  if (file.read(reinterpret_cast<char *>(&header), sizeof(header)) &&
+      header.magic == PROGRAM_CACHE_MAGIC &&
+      header.version == PROGRAM_CACHE_VERSION &&
+      remainingBytes(file) == std::streamoff(header.length)) {
+    // a truncated or corrupt file fails the size check above instead of
+    // asking for a huge buffer here
+    binary.resize(header.length);
+    valid = !binary.empty() && file.read(binary.data(), binary.size());
+  }
+  file.close();
+
+  GLuint programID = 0;
+  GLint linked = GL_FALSE;
+  if (valid) {
+    programID = glCreateProgram();
+    programBinary(programID, header.binaryFormat, binary.data(),
+                  binary.size());
+    glGetProgramiv(programID, GL_LINK_STATUS, &linked);
+  }
+
+  if (!linked) {
+    // stale or corrupt, the driver wants a recompile
+    glDeleteProgram(programID);
+    std::remove(path.c_str());
+    return 0;
+  }
+
+  return programID;
+}
+
+void saveCachedProgram(GLuint programID, const std::string &cacheDir,
+                       const std::string &path) {
+  GLint length = 0;
+  glGetProgramiv(programID, GL_PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0)
+    return;
+
+  ProgramBinaryHeader header;
+  std::vector<char> binary(length);
+  GLenum format = 0;
+  getProgramBinary(programID, length, NULL, &format, binary.data());
+
+  header.magic = PROGRAM_CACHE_MAGIC;
+  header.version = PROGRAM_CACHE_VERSION;
+  header.binaryFormat = format;
+  header.length = static_cast<std::uint32_t>(length);
+
+  mkdir(cacheDir.c_str(), 0755); // fails harmlessly if it exists
+
+  std::ofstream file(path.c_str(), std::ios::out | std::ios::binary);
+  if (!file) {
+    std::cerr << "Could Not Write Shader Cache " << path << std::endl;
+    return;
+  }
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  file.write(binary.data(), binary.size());
+}
+
+} // namespace
+
+bool loadProgramBinaryFunctions(GLADloadproc load) {
+  getProgramBinary =
+      reinterpret_cast<PFNGETPROGRAMBINARY>(load("glGetProgramBinary"));
+  programBinary = reinterpret_cast<PFNPROGRAMBINARY>(load("glProgramBinary"));
+  programParameteri =
+      reinterpret_cast<PFNPROGRAMPARAMETERI>(load("glProgramParameteri"));
+
+  return programBinarySupported();
+}
+
+// Needs the entry points and at least one binary format
+bool programBinarySupported() {
+  if (!getProgramBinary || !programBinary || !programParameteri)
+    return false;
+
+  GLint numFormats = 0;
+  glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+  return numFormats > 0;
+}
+
+std::string programCacheKey(const std::string &vsSource,
+                            const std::string &fsSource) {
+  std::uint64_t hash = hashString(vsSource);
+  hash = hashString(std::string(1, '\0') + fsSource, hash);
+  hash = hashString(glString(GL_VENDOR), hash);
+  hash = hashString(glString(GL_RENDERER), hash);
+  hash = hashString(glString(GL_VERSION), hash);
+
+  std::ostringstream key;
+  key << std::hex << hash;
+  return key.str();
+}
+
+GLuint CreateCachedShaderProgram(const std::string &vsSource,
+                                 const std::string &fsSource,
+                                 const std::string &cacheDir) {
+  TraceScope scope("CreateCachedShaderProgram", "shaders");
+
+  if (!programBinarySupported())
+    return CreateShaderProgram(vsSource, fsSource);
+
+  std::string path =
+      cacheFilePath(cacheDir, programCacheKey(vsSource, fsSource));
+
+  GLuint programID = loadCachedProgram(path);
+  if (programID != 0) {
+    // block bindings are not guaranteed to be part of the binary
+    bindCameraMatricesBlock(programID);
+    return programID;
+  }
+
+  // The retrievable hint has to be set before linking, so the program is
+  // linked a second time here. Only happens on a cache miss.
+  programID = CreateShaderProgram(vsSource, fsSource);
+  if (programID == 0)
+    return 0;
+
+  programParameteri(programID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+  glLinkProgram(programID);
+  if (!checkLinkStatus(programID)) {
+    glDeleteProgram(programID);
+    return CreateShaderProgram(vsSource, fsSource);
+  }
+  bindCameraMatricesBlock(programID);
+
+  saveCachedProgram(programID, cacheDir, path);
+  return programID;
+}
@@ -0,0 +1,77 @@
+/**
+ * File:	SimulationThread.cpp
+ */
+
+#include "SimulationThread.h"
+#include "Trace.h"
+
+#include <algorithm>
+#include <chrono>
+
+typedef std::chrono::steady_clock Clock;
+
+namespace {
+
+// Longest sleep, so pausing, the time scale and stop() are noticed quickly
+const double MAX_SLEEP_SECONDS = 0.005;
+
+} // namespace
+
+SimulationThread::SimulationThread()
+    : m_running(false), m_paused(false), m_timeScale(1.0) {}
+
+SimulationThread::~SimulationThread() { stop(); }
+
+void SimulationThread::start(FixedStepScheduler const &scheduler,
+                             StepFunction step, PublishFunction publish) {
+  stop();
+
+  m_scheduler = scheduler;
+  m_step = step;
+  m_publish = publish;
+
+  m_running = true;
+  m_thread = std::thread(&SimulationThread::run, this);
+}
+
+void SimulationThread::stop() {
+  m_running = false;
+  if (m_thread.joinable())
+    m_thread.join();
+}
+
+bool SimulationThread::running() const { return m_running; }
+
+void SimulationThread::setPaused(bool paused) { m_paused = paused; }
+
+bool SimulationThread::paused() const { return m_paused; }
+
+void SimulationThread::setTimeScale(double scale) {
+  m_timeScale = std::max(scale, 0.0);
+}
+
+double SimulationThread::timeScale() const { return m_timeScale; }
+
+void SimulationThread::run() {
+  Tracer::global().setThreadName("simulation");
+  Clock::time_point last = Clock::now();
+
+  while (m_running) {
+    Clock::time_point now = Clock::now();
+    double elapsed = std::chrono::duration<double>(now - last).count();
+    last = now;
+
+    double scale = m_timeScale;
+    m_scheduler.setTimeScale(scale);
+
+    if (!m_paused && m_scheduler.update(elapsed, std::ref(m_step)) > 0)
+      m_publish(m_scheduler);
+
+    // until the next step is due
+    double wait = MAX_SLEEP_SECONDS;
+    if (!m_paused && scale > 0.0)
+      wait = std::min(wait, (1.0 - m_scheduler.alpha()) *
+                                m_scheduler.stepSeconds() / scale);
+    std::this_thread::sleep_for(std::chrono::duration<double>(wait));
+  }
+}
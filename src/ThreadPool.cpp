@@ -0,0 +1,144 @@
+/**
+ * File:	ThreadPool.cpp
+ */
+
+#include "ThreadPool.h"
+#include "Trace.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+
+// Queue of the pool worker running on this thread, if any
+thread_local ThreadPool const *t_pool = nullptr;
+thread_local std::size_t t_queue = 0;
+
+} // namespace
+
+ThreadPool::ThreadPool(int numWorkers) : m_pendingTasks(0), m_stopping(false) {
+  if (numWorkers < 0)
+    numWorkers = std::max(int(std::thread::hardware_concurrency()) - 1, 0);
+
+  for (int i = 0; i <= numWorkers; ++i)
+    m_queues.emplace_back(new TaskQueue);
+
+  for (int i = 0; i < numWorkers; ++i)
+    m_workers.emplace_back(&ThreadPool::workerLoop, this, std::size_t(i));
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(m_wakeMutex);
+    m_stopping = true;
+  }
+  m_wake.notify_all();
+
+  for (std::thread &worker : m_workers)
+    worker.join();
+}
+
+int ThreadPool::numWorkers() const { return int(m_workers.size()); }
+
+int ThreadPool::concurrency() const { return numWorkers() + 1; }
+
+ThreadPool &ThreadPool::global() {
+  static ThreadPool pool([] {
+    char const *threads = std::getenv("QUAD_ANIMATION_THREADS");
+    return (threads && std::atoi(threads) > 0) ? std::atoi(threads) - 1 : -1;
+  }());
+  return pool;
+}
+
+std::size_t ThreadPool::callerQueue() const {
+  return (t_pool == this) ? t_queue : m_queues.size() - 1;
+}
+
+void ThreadPool::submitAndWait(Job &job, std::size_t first, std::size_t last,
+                               std::size_t grain) {
+  std::size_t numChunks = (last - first + grain - 1) / grain;
+  job.remaining.store(numChunks);
+
+  // counted before they are queued, so a worker never takes a task the
+  // count does not include yet
+  {
+    std::lock_guard<std::mutex> lock(m_wakeMutex);
+    m_pendingTasks += numChunks;
+  }
+
+  // deal the chunks round robin, starting with the caller's own queue. Each
+  // queue gets its chunks last to first: the owner pops from the back and
+  // so runs them in order, thieves take the far end.
+  std::size_t numQueues = m_queues.size();
+  std::size_t home = callerQueue();
+  for (std::size_t q = 0; q < numQueues && q < numChunks; ++q) {
+    TaskQueue &queue = *m_queues[(home + q) % numQueues];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+
+    std::size_t lastChunk = q + (numChunks - 1 - q) / numQueues * numQueues;
+    for (std::size_t c = lastChunk + numQueues; c > q;) {
+      c -= numQueues;
+      std::size_t begin = first + c * grain;
+      Task task = {&job, begin, std::min(begin + grain, last)};
+      queue.tasks.push_back(task);
+    }
+  }
+  m_wake.notify_all();
+
+  // help until every chunk of this job is done (possibly by others)
+  while (job.remaining.load(std::memory_order_acquire) != 0) {
+    if (!runOneTask(home))
+      std::this_thread::yield();
+  }
+}
+
+bool ThreadPool::popTask(std::size_t queue, bool fromBack, Task &task) {
+  TaskQueue &q = *m_queues[queue];
+  std::lock_guard<std::mutex> lock(q.mutex);
+  if (q.tasks.empty())
+    return false;
+
+  if (fromBack) {
+    task = q.tasks.back();
+    q.tasks.pop_back();
+  } else {
+    task = q.tasks.front();
+    q.tasks.pop_front();
+  }
+  return true;
+}
+
+// Own queue first (newest task, still warm in cache), then steal the
+// oldest task of another queue
+bool ThreadPool::runOneTask(std::size_t home) {
+  Task task;
+  bool found = popTask(home, true, task);
+
+  std::size_t numQueues = m_queues.size();
+  for (std::size_t i = 1; !found && i < numQueues; ++i)
+    found = popTask((home + i) % numQueues, false, task);
+
+  if (!found)
+    return false;
+
+  m_pendingTasks.fetch_sub(1);
+  task.job->run(task.job->body, task.begin, task.end);
+  task.job->remaining.fetch_sub(1, std::memory_order_release);
+  return true;
+}
+
+void ThreadPool::workerLoop(std::size_t index) {
+  t_pool = this;
+  t_queue = index;
+  Tracer::global().setThreadName("pool worker");
+
+  for (;;) {
+    if (runOneTask(index))
+      continue;
+
+    std::unique_lock<std::mutex> lock(m_wakeMutex);
+    m_wake.wait(lock, [this] { return m_stopping || m_pendingTasks > 0; });
+    if (m_stopping)
+      return;
+  }
+}
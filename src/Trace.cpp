@@ -0,0 +1,190 @@
+/**
+ * File:	Trace.cpp
+ */
+
+#include "Trace.h"
+
+#include <fstream>
+
+namespace {
+
+thread_local void *t_buffer = nullptr; // the calling thread's ThreadBuffer
+
+// name as a JSON string
+void writeString(std::ostream &out, char const *name) {
+  out << '"';
+  for (char const *c = name; *c; ++c) {
+    switch (*c) {
+    case '"':
+      out << "\\\"";
+      break;
+    case '\\':
+      out << "\\\\";
+      break;
+    case '\n':
+      out << "\\n";
+      break;
+    default:
+      if (static_cast<unsigned char>(*c) >= 0x20)
+        out << *c;
+    }
+  }
+  out << '"';
+}
+
+// Microseconds, the unit of "ts", with the nanoseconds kept as decimals
+void writeMicroseconds(std::ostream &out, long long nanoseconds) {
+  long long fraction = nanoseconds % 1000;
+  out << nanoseconds / 1000 << '.' << char('0' + fraction / 100)
+      << char('0' + fraction / 10 % 10) << char('0' + fraction % 10);
+}
+
+} // namespace
+
+Tracer::Chunk::Chunk() : count(0), next(nullptr) {}
+
+Tracer::ThreadBuffer::ThreadBuffer()
+    : id(0), name(nullptr), head(nullptr), tail(nullptr) {}
+
+Tracer::ThreadBuffer::~ThreadBuffer() {
+  Chunk *chunk = head.load();
+  while (chunk) {
+    Chunk *next = chunk->next.load();
+    delete chunk;
+    chunk = next;
+  }
+}
+
+Tracer &Tracer::global() {
+  static Tracer *tracer = new Tracer;
+  return *tracer;
+}
+
+Tracer::Tracer()
+    : m_enabled(false), m_epoch(std::chrono::steady_clock::now()) {}
+
+void Tracer::start() { m_enabled.store(true, std::memory_order_release); }
+
+void Tracer::stop() { m_enabled.store(false, std::memory_order_release); }
+
+bool Tracer::enabled() const {
+  return m_enabled.load(std::memory_order_acquire);
+}
+
+void Tracer::begin(char const *name, char const *category) {
+  if (enabled())
+    append('B', name, category);
+}
+
+void Tracer::end(char const *name, char const *category) {
+  if (enabled())
+    append('E', name, category);
+}
+
+void Tracer::setThreadName(char const *name) { threadBuffer().name = name; }
+
+Tracer::ThreadBuffer &Tracer::threadBuffer() {
+  if (!t_buffer) {
+    std::lock_guard<std::mutex> lock(m_threadsMutex);
+    m_threads.emplace_back(new ThreadBuffer);
+    m_threads.back()->id = int(m_threads.size());
+    t_buffer = m_threads.back().get();
+  }
+  return *static_cast<ThreadBuffer *>(t_buffer);
+}
+
+void Tracer::append(char phase, char const *name, char const *category) {
+  long long nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                              std::chrono::steady_clock::now() - m_epoch)
+                              .count();
+
+  ThreadBuffer &buffer = threadBuffer();
+  Chunk *chunk = buffer.tail;
+  if (!chunk) {
+    chunk = buffer.tail = new Chunk;
+    buffer.head.store(chunk, std::memory_order_release);
+  }
+
+  std::size_t count = chunk->count.load(std::memory_order_relaxed);
+  if (count == EVENTS_PER_CHUNK) {
+    Chunk *next = new Chunk;
+    chunk->next.store(next, std::memory_order_release);
+    buffer.tail = chunk = next;
+    count = 0;
+  }
+
+  Event &event = chunk->events[count];
+  event.name = name;
+  event.category = category;
+  event.nanoseconds = nanoseconds;
+  event.phase = phase;
+  chunk->count.store(count + 1, std::memory_order_release);
+}
+
+std::size_t Tracer::numEvents() const {
+  std::size_t total = 0;
+
+  std::lock_guard<std::mutex> lock(m_threadsMutex);
+  for (std::unique_ptr<ThreadBuffer> const &buffer : m_threads)
+    for (Chunk const *chunk = buffer->head.load(std::memory_order_acquire);
+         chunk; chunk = chunk->next.load(std::memory_order_acquire))
+      total += chunk->count.load(std::memory_order_acquire);
+  return total;
+}
+
+// The JSON object format of the trace event format: one process, a
+// thread_name metadata event for each named thread, then every thread's
+// events in the order it recorded them
+bool Tracer::writeJson(std::string const &fileName) const {
+  std::ofstream out(fileName.c_str());
+  if (!out)
+    return false;
+
+  out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+  bool first = true;
+
+  std::lock_guard<std::mutex> lock(m_threadsMutex);
+  for (std::unique_ptr<ThreadBuffer> const &buffer : m_threads) {
+    char const *threadName = buffer->name.load();
+    if (threadName) {
+      out << (first ? "\n" : ",\n");
+      out << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, "
+          << "\"tid\": " << buffer->id << ", \"args\": {\"name\": ";
+      writeString(out, threadName);
+      out << "}}";
+      first = false;
+    }
+
+    for (Chunk const *chunk = buffer->head.load(std::memory_order_acquire);
+         chunk; chunk = chunk->next.load(std::memory_order_acquire)) {
+      std::size_t count = chunk->count.load(std::memory_order_acquire);
+      for (std::size_t i = 0; i < count; ++i) {
+        Event const &event = chunk->events[i];
+        out << (first ? "\n" : ",\n");
+        out << "{\"name\": ";
+        writeString(out, event.name);
+        out << ", \"cat\": ";
+        writeString(out, event.category);
+        out << ", \"ph\": \"" << event.phase << "\", \"ts\": ";
+        writeMicroseconds(out, event.nanoseconds);
+        out << ", \"pid\": 1, \"tid\": " << buffer->id << "}";
+        first = false;
+      }
+    }
+  }
+  out << "\n]}\n";
+
+  return bool(out);
+}
+
+TraceScope::TraceScope(char const *name, char const *category)
+    : m_name(name), m_category(category),
+      m_recording(Tracer::global().enabled()) {
+  if (m_recording)
+    Tracer::global().begin(m_name, m_category);
+}
+
+TraceScope::~TraceScope() {
+  if (m_recording)
+    Tracer::global().end(m_name, m_category);
+}
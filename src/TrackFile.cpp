@@ -0,0 +1,305 @@
+/**
+ * File:	TrackFile.cpp
+ */
+
+#include "TrackFile.h"
+#include "ArcLengthTable.h"
+#include "BezierCurve.h"
+#include "Trace.h"
+#include "Vec3f_FileIO.h"
+
+#include <cstring>
+#include <fstream>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using glm::vec3;
+
+const char TRACK_FILE_MAGIC[8] = {'Q', 'A', 'T', 'R', 'A', 'C', 'K', '\0'};
+
+namespace {
+
+uint64_t alignUp(uint64_t offset) {
+  return (offset + TRACK_FILE_ALIGNMENT - 1) &
+         ~uint64_t(TRACK_FILE_ALIGNMENT - 1);
+}
+
+// offset + count * elementSize lies inside a file of fileSize bytes
+bool fitsInFile(uint64_t offset, uint64_t count, uint64_t elementSize,
+                uint64_t fileSize) {
+  if (offset > fileSize || offset % sizeof(float) != 0)
+    return false;
+  return count <= (fileSize - offset) / elementSize;
+}
+
+bool setError(std::string *error, std::string const &message) {
+  if (error)
+    *error = message;
+  return false;
+}
+
+} // namespace
+
+// ====== MappedTrackFile =====================================================
+
+MappedTrackFile::MappedTrackFile()
+    : m_mapping(nullptr), m_mappedSize(0), m_header(nullptr) {}
+
+MappedTrackFile::~MappedTrackFile() { close(); }
+
+MappedTrackFile::MappedTrackFile(MappedTrackFile &&moved)
+    : m_mapping(moved.m_mapping), m_mappedSize(moved.m_mappedSize),
+      m_header(moved.m_header), m_error(std::move(moved.m_error)) {
+  moved.m_mapping = nullptr;
+  moved.m_mappedSize = 0;
+  moved.m_header = nullptr;
+}
+
+MappedTrackFile &MappedTrackFile::operator=(MappedTrackFile &&moved) {
+  if (this != &moved) {
+    close();
+    std::swap(m_mapping, moved.m_mapping);
+    std::swap(m_mappedSize, moved.m_mappedSize);
+    std::swap(m_header, moved.m_header);
+    m_error = std::move(moved.m_error);
+  }
+  return *this;
+}
+
+bool MappedTrackFile::open(std::string const &fileName) {
+  close();
+  m_error.clear();
+
+  int fd = ::open(fileName.c_str(), O_RDONLY);
+  if (fd < 0)
+    return fail("Unable to open file: " + fileName);
+
+  struct stat info;
+  if (fstat(fd, &info) != 0 || info.st_size < off_t(sizeof(TrackFileHeader))) {
+    ::close(fd);
+    return fail("Not a track file (too small): " + fileName);
+  }
+
+  std::size_t size = static_cast<std::size_t>(info.st_size);
+  void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd); // the mapping keeps the file referenced
+
+  if (mapping == MAP_FAILED)
+    return fail("Unable to map file: " + fileName);
+
+  // points are usually consumed front to back (upload, tessellation)
+  madvise(mapping, size, MADV_SEQUENTIAL);
+
+  m_mapping = mapping;
+  m_mappedSize = size;
+  m_header = static_cast<TrackFileHeader const *>(mapping);
+
+  TrackFileHeader const &h = *m_header;
+  if (std::memcmp(h.magic, TRACK_FILE_MAGIC, sizeof(h.magic)) != 0)
+    return fail("Not a track file (bad magic): " + fileName);
+  if (h.version == 0 || h.version > TRACK_FILE_VERSION)
+    return fail("Unsupported track file version " +
+                std::to_string(h.version) + ": " + fileName);
+  if (h.fileSize != size)
+    return fail("Truncated track file: " + fileName);
+  if (!fitsInFile(h.pointsOffset, h.numPoints, sizeof(vec3), size))
+    return fail("Corrupt point array in track file: " + fileName);
+  if ((h.flags & TRACK_HAS_ARC_LENGTHS) &&
+      (h.arcLengthSamplesPerSegment == 0 ||
+       !fitsInFile(h.arcLengthsOffset, h.numArcLengths, sizeof(float), size)))
+    return fail("Corrupt arc length table in track file: " + fileName);
+
+  return true;
+}
+
+void MappedTrackFile::close() {
+  if (m_mapping)
+    munmap(m_mapping, m_mappedSize);
+
+  m_mapping = nullptr;
+  m_mappedSize = 0;
+  m_header = nullptr;
+}
+
+bool MappedTrackFile::fail(std::string const &message) {
+  close();
+  m_error = message;
+  return false;
+}
+
+bool MappedTrackFile::isOpen() const { return m_header != nullptr; }
+
+std::string const &MappedTrackFile::error() const { return m_error; }
+
+TrackFileHeader const &MappedTrackFile::header() const { return *m_header; }
+
+std::size_t MappedTrackFile::numPoints() const {
+  return m_header ? static_cast<std::size_t>(m_header->numPoints) : 0;
+}
+
+vec3 const *MappedTrackFile::points() const {
+  if (!m_header)
+    return nullptr;
+  return reinterpret_cast<vec3 const *>(static_cast<char const *>(m_mapping) +
+                                        m_header->pointsOffset);
+}
+
+std::size_t MappedTrackFile::pointsByteSize() const {
+  return numPoints() * sizeof(vec3);
+}
+
+bool MappedTrackFile::hasArcLengths() const {
+  return m_header && (m_header->flags & TRACK_HAS_ARC_LENGTHS);
+}
+
+int MappedTrackFile::arcLengthSamplesPerSegment() const {
+  return hasArcLengths() ? int(m_header->arcLengthSamplesPerSegment) : 0;
+}
+
+std::size_t MappedTrackFile::numArcLengths() const {
+  return hasArcLengths() ? static_cast<std::size_t>(m_header->numArcLengths)
+                         : 0;
+}
+
+float const *MappedTrackFile::arcLengths() const {
+  if (!hasArcLengths())
+    return nullptr;
+  return reinterpret_cast<float const *>(
+      static_cast<char const *>(m_mapping) + m_header->arcLengthsOffset);
+}
+
+void MappedTrackFile::loadArcLengthTable(ArcLengthTable &table) const {
+  loadArcLengthTable(std::vector<vec3>(points(), points() + numPoints()),
+                     table);
+}
+
+void MappedTrackFile::loadArcLengthTable(
+    std::vector<vec3> const &controlPoints, ArcLengthTable &table) const {
+  if (!hasArcLengths() ||
+      !table.assign(controlPoints, arcLengthSamplesPerSegment(), arcLengths(),
+                    numArcLengths()))
+    table.build(controlPoints);
+}
+
+// ====== Writing =============================================================
+
+bool writeTrackFile(std::string const &fileName, vec3 const *points,
+                    std::size_t numPoints, ArcLengthTable const *table,
+                    std::string *error) {
+  bool withLengths = table && !table->empty();
+
+  TrackFileHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, TRACK_FILE_MAGIC, sizeof(header.magic));
+  header.version = TRACK_FILE_VERSION;
+  header.numPoints = numPoints;
+  header.pointsOffset = alignUp(sizeof(TrackFileHeader));
+
+  uint64_t end = header.pointsOffset + numPoints * sizeof(vec3);
+  if (withLengths) {
+    header.flags |= TRACK_HAS_ARC_LENGTHS;
+    header.arcLengthSamplesPerSegment = table->samplesPerSegment();
+    header.numArcLengths = table->size();
+    header.arcLengthsOffset = alignUp(end);
+    end = header.arcLengthsOffset + table->size() * sizeof(float);
+  }
+  header.fileSize = end;
+
+  std::ofstream file(fileName, std::ios::out | std::ios::binary |
+                                   std::ios::trunc);
+  if (!file)
+    return setError(error, "Unable to create file: " + fileName);
+
+  static const char padding[TRACK_FILE_ALIGNMENT] = {};
+  uint64_t written = 0;
+
+  auto writeAt = [&](uint64_t offset, void const *data, uint64_t bytes) {
+    file.write(padding, offset - written);
+    file.write(static_cast<char const *>(data), bytes);
+    written = offset + bytes;
+  };
+
+  writeAt(0, &header, sizeof(header));
+  writeAt(header.pointsOffset, points, numPoints * sizeof(vec3));
+  if (withLengths)
+    writeAt(header.arcLengthsOffset, table->lengths().data(),
+            table->size() * sizeof(float));
+
+  file.close();
+  if (!file)
+    return setError(error, "Unable to write file: " + fileName);
+
+  return true;
+}
+
+bool convertTextTrackFile(std::string const &textFileName,
+                          std::string const &trackFileName,
+                          int samplesPerSegment, std::string *error) {
+  VectorContainerVec3f vecs;
+  Vec3fFileStatus status = loadVec3fFromFile(vecs, textFileName);
+  if (!status.ok())
+    return setError(error, status.message);
+
+  std::vector<vec3> points;
+  points.reserve(vecs.size());
+  for (Vec3f const &v : vecs)
+    points.push_back(vec3(v.x(), v.y(), v.z()));
+
+  ArcLengthTable table;
+  if (samplesPerSegment > 0)
+    table.build(points, samplesPerSegment);
+
+  return writeTrackFile(trackFileName, points.data(), points.size(), &table,
+                        error);
+}
+
+// ====== Loading =============================================================
+
+std::vector<vec3> defaultTrackControlPoints() {
+  return {vec3(0, 0, 0),  vec3(5, 5, 0),  vec3(5, 5, 5), vec3(0, 0, 5),
+          vec3(-5, 5, 5), vec3(-5, 5, 0), vec3(0, 0, 0)};
+}
+
+bool loadTrack(std::string const &fileName, std::vector<vec3> &controlPoints,
+               ArcLengthTable &table, std::string *error) {
+  TraceScope scope("loadTrack", "load");
+
+  const std::string extension = ".trk";
+  bool binary = fileName.size() >= extension.size() &&
+                fileName.compare(fileName.size() - extension.size(),
+                                 extension.size(), extension) == 0;
+
+  if (binary) {
+    MappedTrackFile track;
+    if (!track.open(fileName))
+      return setError(error, track.error());
+
+    controlPoints.assign(track.points(), track.points() + track.numPoints());
+    track.loadArcLengthTable(controlPoints, table);
+  } else {
+    VectorContainerVec3f vecs;
+    Vec3fFileStatus status = loadVec3fFromFile(vecs, fileName);
+    if (!status.opened)
+      return setError(error, status.message);
+    if (status.numErrors > 0)
+      setError(error, status.message + " (" +
+                          std::to_string(status.numErrors) +
+                          " lines skipped)");
+
+    controlPoints.clear();
+    controlPoints.reserve(vecs.size());
+    for (Vec3f const &v : vecs)
+      controlPoints.push_back(vec3(v.x(), v.y(), v.z()));
+    table.build(controlPoints);
+  }
+
+  if (numBezierSegments(controlPoints.size()) == 0)
+    return setError(error, fileName + " has no complete Bezier segment");
+
+  return true;
+}
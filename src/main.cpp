@@ -21,19 +21,40 @@
  * ogldev.atspace.co.uk -> good resource
  */
 
+#include <algorithm>
+#include <atomic>
 #include <iostream>
 #include <cmath>
+#include <cstddef>
 #include <chrono>
+#include <cstdlib>
 #include <limits>
+#include <mutex>
 #include <string>
 #include <vector>
+#include <sys/stat.h>
 
 #include "glad/glad.h"
 #include <GLFW/glfw3.h>
 
 #include "ShaderTools.h"
+#include "ShaderProgram.h"
 #include "OpenGLMatrixTools.h"
 #include "Camera.h"
+#include "BezierCurve.h"
+#include "ArcLengthTable.h"
+#include "EditableTrack.h"
+#include "MeshGenerator.h"
+#include "InstanceTransform.h"
+#include "TrackFile.h"
+#include "FixedStepScheduler.h"
+#include "SimulationThread.h"
+#include "TripleBuffer.h"
+#include "CoasterPhysics.h"
+#include "Profiler.h"
+#include "GpuTimer.h"
+#include "Trace.h"
+#include "FrameCapture.h"
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -47,13 +68,19 @@ using namespace glm;
 *	appropriate classes or abstractions.
 */
 
-// Drawing Program
-GLuint basicProgramID;
+// Drawing Programs, and their uniform locations (looked up once)
+ShaderProgram basicProgram;
+GLint basic_objectIndexLocation;
+GLint basic_colorLocation;
 
-// Data needed for Quad
+ShaderProgram instancedProgram;
+GLint instanced_colorLocation;
+
+// Data needed for Quad (the bead mesh, drawn once per car)
 GLuint vaoID;
 GLuint vertBufferID;
-mat4 M;
+GLuint indexBufferID;
+GLuint instanceBufferID;
 
 // Data needed for Line 
 GLuint line_vaoID;
@@ -61,20 +88,105 @@ GLuint line_vertBufferID;
 mat4 line_M;
 
 //Curve DS
-vector<vec3> curve;
-vector<vec3> sphere;
-vector<vec2> textureCoords;
-
-//globals
-float PI =  atan(1.0)*4.0;
+// The track as drawn, re-tessellated only where its control points move
+// (see EditableTrack.h). The simulation rides its own copy, simTrack, which
+// gets the same edits through g_trackEdits.
+EditableTrack g_track(16, 0);
+EditableTrack simTrack(0);
+std::mutex g_trackEditMutex;
+vector<TrackEdit> g_trackEdits; // not applied to simTrack yet
+std::atomic<bool> g_trackEdited(false);
+size_t g_selectedPoint = 0; // control point moved by right dragging
+bool g_draggingPoint = false;
+IndexedMesh sphere;
+MeshTopology g_sphereTopology = MESH_TRIANGLE_STRIPS;
+
+// Cars (beads) sharing the sphere mesh, all drawn by one instanced call
+int g_numCars = 10;
+float g_carSpacing = 0.7; // distance along the track between cars
+vector<InstanceTransform> carInstances; // drawn, between the sim states
+vector<ArcLengthCursor> carCursors;
+
+// Simulation at a fixed rate on its own thread (see FixedStepScheduler.h
+// and SimulationThread.h). Once the thread runs, g_coaster, simTrack,
+// carCursors, simCars and previousSimCars belong to it; the render thread
+// only sees the snapshots it publishes.
+FixedStepScheduler g_scheduler(1.0 / 1000.0);
+SimulationThread g_simulationThread;
+CoasterSimulation g_coaster; // one train, the cars follow its lead car
+vector<InstanceTransform> simCars;
+vector<InstanceTransform> previousSimCars;
+
+// What the render thread needs of one simulation update: the cars after the
+// last two steps, drawn interpolated between them
+struct SimulationSnapshot {
+  vector<InstanceTransform> previous;
+  vector<InstanceTransform> current;
+  float alpha;        // scheduler alpha when published
+  double stepSeconds; // real time per step at the time scale then
+  std::chrono::steady_clock::time_point published;
+};
+TripleBuffer<SimulationSnapshot> g_snapshots;
+
+// Where the milliseconds go (see Profiler.h and GpuTimer.h): CPU time of
+// the sections of a frame and of the simulation steps, GPU time of the draws
+Profiler g_profiler;
+GpuTimer g_gpuTimer(g_profiler);
+const int PROFILE_FRAME = g_profiler.section("frame");
+const int PROFILE_CONSUME = g_profiler.section("consumeSnapshot");
+const int PROFILE_UPLOAD_EDITS = g_profiler.section("uploadTrackEdits");
+const int PROFILE_DISPLAY = g_profiler.section("displayFunc");
+const int PROFILE_DRAW_CARS = g_profiler.section("displayFunc/cars");
+const int PROFILE_DRAW_LINE = g_profiler.section("displayFunc/line");
+const int PROFILE_DRAW_CARS_GPU = g_profiler.section("displayFunc/cars (GPU)");
+const int PROFILE_DRAW_LINE_GPU = g_profiler.section("displayFunc/line (GPU)");
+const int PROFILE_MOVE_CAMERA = g_profiler.section("moveCamera");
+const int PROFILE_SWAP = g_profiler.section("swapBuffers");
+const int PROFILE_SIMULATION_STEP = g_profiler.section("simulation step");
+// seconds between reports to stdout, 0 for none; 'p' switches them on and
+// off, QUAD_ANIMATION_PROFILE sets it at start up
+double g_profileReportSeconds = 0.0;
+const double DEFAULT_PROFILE_REPORT_SECONDS = 5.0;
+// Chrome trace of the whole run (see Trace.h), written at exit when
+// QUAD_ANIMATION_TRACE names a file
+string g_traceFileName;
+
+// --headless: no visible window and no vsync, frames are drawn into an
+// OffscreenTarget and written to outputDir as an image sequence (see
+// FrameCapture.h). The simulation is stepped on the render thread by 1/fps
+// per frame instead of by the clock, so every run of a track gives the same
+// frames however fast they are rendered.
+struct HeadlessOptions {
+  bool enabled;
+  int frames;
+  double fps;
+  int samples; // multisampling of the offscreen target, 0 for none
+  bool ride;   // on the lead car from the first frame
+  string outputDir;
+};
+HeadlessOptions g_headless = {false, 300, 30.0, 0, false, "frames"};
 
 // Only one camera so only one veiw and perspective matrix are needed.
 mat4 V;
 mat4 P;
 
-// Only one thing is rendered at a time, so only need one MVP
-// When drawing different objects, update M and MVP = M * V * P
-mat4 MVP;
+// std140 layout of the CameraMatrices uniform block (see ShaderTools.h),
+// written once per frame and shared by every program
+struct CameraMatrices {
+  mat4 view;
+  mat4 projection;
+  mat4 viewProjection;
+};
+GLuint cameraBufferID;
+
+// Every object's model matrix, uploaded in one go to the ObjectTransforms
+// uniform block (see basic_vs.glsl). The shader applies the camera's
+// viewProjection, each draw only selects its entry with objectIndex.
+enum { LINE_OBJECT = 0, NUM_OBJECTS };
+const int MAX_OBJECTS = 256; // must match basic_vs.glsl
+const GLuint OBJECT_TRANSFORMS_BINDING = 0;
+vector<mat4> modelMatrices(NUM_OBJECTS);
+GLuint modelBufferID;
 
 // Camera and veiwing Stuff
 Camera camera;
@@ -90,6 +202,12 @@ bool g_cursorLocked;
 float g_cursorX, g_cursorY;
 
 bool g_play = false;
+bool g_ride = false; // camera on the lead car (see Camera::startRide())
+const float RIDE_BLEND_SECONDS = 0.75f;
+
+// linked program binaries, reused on the next launch
+const string SHADER_CACHE_DIR = "./shader_cache";
+string g_trackFileName; // first command line argument, .trk or text
 
 int WIN_WIDTH = 800, WIN_HEIGHT = 600;
 int FB_WIDTH = 800, FB_HEIGHT = 600;
@@ -106,14 +224,14 @@ void generateIDs();
 void deleteIDs();
 void setupVAO();
 void loadQuadGeometryToGPU();
-float toRadians(float degree);
-void getSpherePoints(float radius, vec3 center);
-void loadCurve();
-vec3 calcPoint(vec3 a, vec3 b, vec3 c, vec3 d, float t);
-vec3 lerp(vec3 a, vec3 b, float t);
+void editControlPoint(size_t index, vec3 const &position);
+void dragControlPoint(float deltaX, float deltaY);
+void selectControlPoint(int offset);
+void uploadTrackEdits();
+void applyTrackEdits();
 void reloadProjectionMatrix();
 void loadModelViewMatrix();
-void setupModelViewProjectionTransform();
+void setupModelTransforms();
 
 void windowSetSizeFunc();
 void windowKeyFunc(GLFWwindow *window, int key, int scancode, int action,
@@ -126,10 +244,30 @@ void windowMouseButtonFunc(GLFWwindow *window, int button, int action,
 void windowMouseMotionFunc(GLFWwindow *window, double x, double y);
 void windowKeyFunc(GLFWwindow *window, int key, int scancode, int action,
                    int mods);
-void animateBead(float t);
+void setupCoaster();
+void animateBead();
+void startSimulation();
+void stepSimulation(double time, double dt);
+void publishSnapshot(FixedStepScheduler const &scheduler);
+void consumeSnapshot();
+void interpolateCars(SimulationSnapshot const &snapshot, float alpha);
 void moveCamera();
-void reloadMVPUniform();
+void runWindowed(GLFWwindow *window);
+void runHeadless();
+bool parseArguments(int argc, char **argv);
+void setupProfiler();
+void setupTracing();
+void writeTrace();
+void reportProfile(double now, double &lastReport);
+void updateRideCamera(float frameSeconds);
+void reloadModelUniform();
+void reloadObjectIndexUniform(int index);
+void reloadInstanceBuffer();
+void reloadCameraBuffer();
+void reloadInstancedUniforms(float r, float g, float b);
 void reloadColorUniform(float r, float g, float b);
+void uploadMatrixBuffer(GLenum target, GLuint bufferID,
+                        vector<mat4> const &matrices);
 std::string GL_ERROR();
 int main(int, char **);
 
@@ -149,50 +287,153 @@ void print4x4Matrix(mat4 mat)
 }
 
 void displayFunc() {
+  ProfileScope displayScope(g_profiler, PROFILE_DISPLAY);
+
   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
   glClearColor(0.3, 0.3, 0.3, 1.0);
 
-  // Use our shader
-  glUseProgram(basicProgramID);
+  // view and projection for every program, once per frame
+  reloadCameraBuffer();
+
+  // ===== DRAW CARS ====== //
+  {
+    ProfileScope scope(g_profiler, PROFILE_DRAW_CARS);
+    GpuScope gpuScope(g_gpuTimer, PROFILE_DRAW_CARS_GPU);
+
+    // every car's transform in one upload, every car in one draw call
+    reloadInstanceBuffer();
+    reloadInstancedUniforms(1, 0, 1);
+
+    // Use VAO that holds buffer bindings
+    // and attribute config of buffers
+    glBindVertexArray(vaoID);
+    // Draw the sphere through its index buffer (bound in the VAO)
+    glDrawElementsInstanced(sphere.topology == MESH_TRIANGLE_STRIPS
+                                ? GL_TRIANGLE_STRIP
+                                : GL_TRIANGLES,
+                            sphere.indices.size(), GL_UNSIGNED_SHORT,
+                            (void *)0, carInstances.size());
+  }
 
-  // ===== DRAW QUAD ====== //
-  MVP = P * V * M;
-  reloadMVPUniform();
-  reloadColorUniform(1, 0, 1);
+  // ==== DRAW LINE ===== //
+  {
+    ProfileScope scope(g_profiler, PROFILE_DRAW_LINE);
+    GpuScope gpuScope(g_gpuTimer, PROFILE_DRAW_LINE_GPU);
 
-  // Use VAO that holds buffer bindings
-  // and attribute config of buffers
-  glBindVertexArray(vaoID);
-  // Draw Quads, start at vertex 0, draw 4 of them (for a quad)
-  glDrawArrays(GL_TRIANGLE_STRIP, 0, sphere.size());
+    // Use our shader
+    basicProgram.use();
 
-  // ==== DRAW LINE ===== //
-  MVP = P * V * line_M;
-  reloadMVPUniform();
+    // All model matrices in one upload
+    setupModelTransforms();
+    reloadModelUniform();
 
-  reloadColorUniform(0, 1, 1);
+    reloadObjectIndexUniform(LINE_OBJECT);
+    reloadColorUniform(0, 1, 1);
 
-  // Use VAO that holds buffer bindings
-  // and attribute config of buffers
-  glBindVertexArray(line_vaoID);
-  // Draw lines
-  glDrawArrays(GL_LINE_STRIP, 0, curve.size());
+    // Use VAO that holds buffer bindings
+    // and attribute config of buffers
+    glBindVertexArray(line_vaoID);
+    // Draw lines
+    glDrawArrays(GL_LINE_STRIP, 0, g_track.vertices().size());
+  }
   
 }
 
-void animateBead(float t) {
-  //M = RotateAboutYMatrix(100 * t);
+// One train waiting at the bottom of the lift
+void setupCoaster() {
+  g_coaster.setTrack(simTrack.arcLengthTable());
+
+  CoasterParameters parameters = defaultCoasterParameters(g_coaster);
+  g_coaster.setParameters(parameters);
+
+  g_coaster.addTrain(0.f, parameters.chainSpeed);
+}
+
+// Places the cars of the train, each g_carSpacing behind the one in front,
+// oriented along the track
+void animateBead() {
+  simCars.resize(g_numCars);
+  carCursors.resize(g_numCars);
+
+  ArcLengthTable const &arcLengthTable = simTrack.arcLengthTable();
+  float lead = (g_coaster.numTrains() > 0) ? g_coaster.distance(0) : 0.f;
+  for (int i = 0; i < g_numCars; ++i) {
+    float s = arcLengthTable.wrap(lead - i * g_carSpacing);
+    ArcLengthSample sample = arcLengthTable.sampleAt(s, carCursors[i]);
+    vec3 position = arcLengthTable.positionAt(s, carCursors[i]);
+    Quat4f orientation = simTrack.frames().orientationAt(sample);
+
+    simCars[i].positionScale = vec4(position, 1.f);
+    simCars[i].orientation = vec4(orientation.im().x(), orientation.im().y(),
+                                  orientation.im().z(), orientation.re());
+  }
+}
+
+void startSimulation() {
+  g_simulationThread.setPaused(!g_play);
+  g_simulationThread.start(g_scheduler, stepSimulation, publishSnapshot);
+}
+
+// Simulation thread (render thread in headless mode)
+void stepSimulation(double, double dt) {
+  ProfileScope scope(g_profiler, PROFILE_SIMULATION_STEP);
+  TraceScope trace("simulation step", "simulation");
 
-  //float s = (sin(t) + 1.f) / 2.f;
-  float x = (1 - t) * (10) + t * (-10);
+  applyTrackEdits();
+  previousSimCars.swap(simCars);
+  g_coaster.step(dt);
+  animateBead();
+}
+
+// Simulation thread (or before it starts): copies the car states out
+void publishSnapshot(FixedStepScheduler const &scheduler) {
+  SimulationSnapshot &snapshot = g_snapshots.writeBuffer();
+  snapshot.previous = previousSimCars;
+  snapshot.current = simCars;
+  snapshot.alpha = scheduler.alpha();
+  snapshot.stepSeconds = (scheduler.timeScale() > 0.0)
+                             ? scheduler.stepSeconds() / scheduler.timeScale()
+                             : 0.0;
+  snapshot.published = std::chrono::steady_clock::now();
+  g_snapshots.publish();
+}
+
+// Render thread: the newest snapshot, advanced by the time since it was
+// published, never waits for the simulation. In headless mode the snapshot
+// is of this frame's time already.
+void consumeSnapshot() {
+  ProfileScope scope(g_profiler, PROFILE_CONSUME);
+
+  g_snapshots.update();
+  SimulationSnapshot const &snapshot = g_snapshots.readBuffer();
+
+  float alpha = 1.f;
+  if (g_headless.enabled) {
+    alpha = snapshot.alpha;
+  } else if (snapshot.stepSeconds > 0.0) {
+    double since = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - snapshot.published)
+                       .count();
+    alpha = std::min(snapshot.alpha + float(since / snapshot.stepSeconds), 1.f);
+  }
+
+  interpolateCars(snapshot, alpha);
+}
 
-  //M = TranslateMatrix(x, 0, 0) * M;
+void interpolateCars(SimulationSnapshot const &snapshot, float alpha) {
+  vector<InstanceTransform> const &previous = snapshot.previous;
+  vector<InstanceTransform> const &current = snapshot.current;
 
-  setupModelViewProjectionTransform();
-  reloadMVPUniform();
+  carInstances.resize(current.size());
+  for (size_t i = 0; i < current.size(); ++i)
+    carInstances[i] = (i < previous.size())
+                          ? interpolate(previous[i], current[i], alpha)
+                          : current[i];
 }
 
 void loadQuadGeometryToGPU() {
+  TraceScope scope("loadQuadGeometryToGPU", "upload");
+
   // Just basic layout of floats, for a quad
   // 3 floats per vertex, 4 vertices
   //std::vector<vec3> verts;
@@ -200,170 +441,129 @@ void loadQuadGeometryToGPU() {
   //verts.push_back(Vec3f(-1, 1, 0));
   //verts.push_back(Vec3f(1, -1, 0));
   //verts.push_back(Vec3f(1, 1, 0));
-  getSpherePoints(0.3, vec3(0,0,0));
+  if (!getSpherePoints(0.3, vec3(0, 0, 0), sphere, g_sphereTopology))
+    cout << "sphere has too many vertices for 16 bit indices" << endl;
 
   glBindBuffer(GL_ARRAY_BUFFER, vertBufferID);
   glBufferData(GL_ARRAY_BUFFER,
-               sizeof(vec3) * sphere.size(), // byte size of Vec3f, 4 of them
-               sphere.data(),      // pointer (Vec3f*) to contents of verts
-               GL_STATIC_DRAW);   // Usage pattern of GPU buffer
-}
-
-float toRadians(float degree)
-{
-	return (degree * PI) / 180.0;
-}
+               sizeof(vec3) * sphere.vertices.size(), // byte size of verts
+               sphere.vertices.data(), // pointer (vec3*) to contents of verts
+               GL_STATIC_DRAW);        // Usage pattern of GPU buffer
 
-void getSpherePoints(float radius, vec3 center)
-{
-	float x1,x2,x3,x4,y1,y2,y3,y4,z1,z2,z3,z4;
-	int d = 5;	
-	int layers 		= 180/d;
-	int loop_layer 	= 0;
-	float u1 = 1.0;
-	float v1 = 1.0;
-	float inc = d/360.0;
-	
-	//cout << inc << endl;
-	
-	for(int j = 0.0; j <= 180.0; j = j + d)
-	{
-		for(int i = 0.0; i <= 360.0; i = i + d)
-		{			
-				x1 = (radius * cos(toRadians(i)) * sin(toRadians(j))) + center.x;
-				y1 = (radius * cos(toRadians(j))) + center.y;
-				z1 = (radius * sin(toRadians(i)) * sin(toRadians(j))) + center.z;				
-								
-				x2 = (radius * cos(toRadians(i)) * sin(toRadians(j+d))) + center.x;
-				y2 = (radius * cos(toRadians(j+d))) + center.y;
-				z2 = (radius * sin(toRadians(i)) * sin(toRadians(j+d))) + center.z;				
-				
-				x3 = (radius * cos(toRadians(i+d)) * sin(toRadians(j+d))) + center.x;
-				y3 = (radius * cos(toRadians(j+d))) + center.y;
-				z3 = (radius * sin(toRadians(i+d)) * sin(toRadians(j+d))) + center.z;
-				
-				sphere.push_back(vec3(x1,y1,z1));
-				sphere.push_back(vec3(x2,y2,z2));
-				sphere.push_back(vec3(x3,y3,z3));
-				
-				textureCoords.push_back(vec2(u1,v1));				//1
-				textureCoords.push_back(vec2(u1,v1-(2*inc)));		//2
-				textureCoords.push_back(vec2(u1-inc,v1-(2*inc)));	//3
-				
-				//cout << x1 << " " << y1 << " " << z1 << endl;
-				
-				if((loop_layer != 0) && (loop_layer != layers))
-				{
-					x4 = (radius * cos(toRadians(i+d)) * sin(toRadians(j))) + center.x;
-					y4 = (radius * cos(toRadians(j))) + center.y;
-					z4 = (radius * sin(toRadians(i+d)) * sin(toRadians(j))) + center.z;
-					
-					sphere.push_back(vec3(x1,y1,z1));
-					sphere.push_back(vec3(x3,y3,z3));
-					sphere.push_back(vec3(x4,y4,z4));
-						
-					textureCoords.push_back(vec2(u1,v1));				//1
-					textureCoords.push_back(vec2(u1-inc,v1-(2*inc)));	//3
-					textureCoords.push_back(vec2(u1-inc,v1));			//4
-					
-				}
-				u1 -= inc; 
-		}
-		v1 -= 2.0*inc;
-		u1 = 1.0;
-		loop_layer++;
-	}
+  // element buffer binding is part of the VAO state
+  glBindVertexArray(vaoID);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBufferID);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+               sizeof(sphere.indices[0]) * sphere.indices.size(),
+               sphere.indices.data(), GL_STATIC_DRAW);
+  glBindVertexArray(0);
 }
 
 void loadLineGeometryToGPU() {
-  // Just basic layout of floats, for a quad
-  // 3 floats per vertex, 4 vertices
+  TraceScope scope("loadLineGeometryToGPU", "upload");
+
+  string error;
+  vector<vec3> controlPoints;
+  ArcLengthTable arcLengthTable;
+  bool loaded = !g_trackFileName.empty() &&
+                loadTrack(g_trackFileName, controlPoints, arcLengthTable, &error);
+  if (!error.empty())
+    cout << error << endl;
 
-  curve.push_back(vec3(0, 0, 0));
-  curve.push_back(vec3(5, 5, 0));
-  curve.push_back(vec3(5, 5, 5));
-  curve.push_back(vec3(0, 0, 5));
-  curve.push_back(vec3(-5, 5, 5));	
-  curve.push_back(vec3(-5, 5, 0));	
-  curve.push_back(vec3(0, 0, 0));				
+  if (!loaded)
+    controlPoints = defaultTrackControlPoints();
 
-  loadCurve();
+  g_track.reset(controlPoints);
+  simTrack.reset(controlPoints, arcLengthTable);
 
-  cout << curve.size() << endl;
-  for(unsigned int i = 0; i < curve.size(); i++)
-	//cout << curve[i] << endl;
+  cout << g_track.vertices().size() << endl;
 
+  // edits replace parts of it with glBufferSubData (uploadTrackEdits())
   glBindBuffer(GL_ARRAY_BUFFER, line_vertBufferID);
   glBufferData(GL_ARRAY_BUFFER,
-               sizeof(vec3) * curve.size(), // byte size of Vec3f, 4 of them
-               &curve[0],      // pointer (Vec3f*) to contents of verts
-               GL_STATIC_DRAW);   // Usage pattern of GPU buffer
+               sizeof(vec3) * g_track.vertices().size(), // byte size
+               g_track.vertices().data(), // pointer (vec3*) to contents
+               GL_DYNAMIC_DRAW);          // Usage pattern of GPU buffer
 }
 
-void loadCurve()
-{
-	//check for right size of verts
-	if((curve.size() - 1) % 3  != 0)
-		cout << "vertex list is not 3n-1 in size.";
-		
-	vec3 p0, p1, p2, p3;
-	int numSegments = (curve.size()-1)/3;
-	int numLines = 100;
-	vector<vec3> tmp;
-	
-
-	cout << numSegments << endl;
-
-	for(int i = 0; i < numSegments*3; i=i+3)
-	{
-		p0 = curve[i];
-		p1 = curve[i+1];
-		p2 = curve[i+2];
-		p3 = curve[i+3];
-		
-
-		//create B(i)
-		//step t from 0-1
-		float t = 0.00;
-		
-		for(int j = 0; j < 2*numLines/numSegments; j++)
-		{
-			vec3 point = calcPoint(p0,p1,p2,p3,t);			
-			tmp.push_back(point);
-			t += 0.01;
-		}	
-	}	
-	curve = tmp;
+// Render thread: moves the drawn control point now, the simulation picks
+// the edit up at its next step
+void editControlPoint(size_t index, vec3 const &position) {
+  g_track.setControlPoint(index, position);
+
+  TrackEdit edit = {index, position};
+  std::lock_guard<std::mutex> lock(g_trackEditMutex);
+  g_trackEdits.push_back(edit);
+  g_trackEdited = true;
 }
 
-vec3 calcPoint(vec3 a, vec3 b, vec3 c, vec3 d, float t)
-{
-	vec3 ab,bc,cd,abbc,bccd;
-	ab = lerp(a,b,t);
-	bc = lerp(b,c,t);
-	cd = lerp(c,d,t);
-	abbc = lerp(ab,bc,t);
-	bccd = lerp(bc,cd,t);
-	return lerp(abbc,bccd,t);
+// Moves the selected control point in the view plane, as far as the cursor
+// moved on screen at the depth of the point
+void dragControlPoint(float deltaX, float deltaY) {
+  vector<vec3> const &points = g_track.controlPoints();
+  if (g_selectedPoint >= points.size())
+    return;
+
+  vec3 point = points[g_selectedPoint];
+  float depth =
+      std::max(dot(point - camera.position(), camera.forward()), WIN_NEAR);
+  float perPixel =
+      2.f * depth * std::tan(radians(WIN_FOV) * 0.5f) / WIN_HEIGHT;
+
+  vec3 right = normalize(cross(camera.forward(), camera.up()));
+  vec3 up = normalize(cross(right, camera.forward()));
+  editControlPoint(g_selectedPoint,
+                   point + (right * deltaX - up * deltaY) * perPixel);
 }
 
-vec3 lerp(vec3 a, vec3 b, float t)
-{
-    return (a + (b-a)*t);
+void selectControlPoint(int offset) {
+  size_t numPoints = g_track.controlPoints().size();
+  if (numPoints == 0)
+    return;
+
+  g_selectedPoint = (g_selectedPoint + numPoints + offset) % numPoints;
+  vec3 const &point = g_track.controlPoints()[g_selectedPoint];
+  cout << "control point " << g_selectedPoint << ": " << point.x << " "
+       << point.y << " " << point.z << endl;
 }
 
-float calcCurveLength() 
-{
-    float l = 0.0;
-    vec3 currPoint = curve[0];
+// Re-tessellates the edited segments and sends only their vertices
+void uploadTrackEdits() {
+  ProfileScope scope(g_profiler, PROFILE_UPLOAD_EDITS);
+  TraceScope trace("uploadTrackEdits", "upload");
 
-    for(unsigned int i = 1; i <= curve.size(); i++)
-    {
-        l += length(currPoint - curve[i]);
-        currPoint = curve[i];
-    }
+  if (!g_track.update())
+    return;
 
-    return l;
+  vector<vec3> const &vertices = g_track.vertices();
+  glBindBuffer(GL_ARRAY_BUFFER, line_vertBufferID);
+  for (VertexRange const &range : g_track.updatedVertices())
+    glBufferSubData(GL_ARRAY_BUFFER, sizeof(vec3) * range.first,
+                    sizeof(vec3) * range.count, &vertices[range.first]);
+}
+
+// Simulation thread: re-measures the edited segments, and samples the
+// heights again from the first of them on. The trains keep going.
+void applyTrackEdits() {
+  if (!g_trackEdited.load())
+    return;
+
+  vector<TrackEdit> edits;
+  {
+    std::lock_guard<std::mutex> lock(g_trackEditMutex);
+    edits.swap(g_trackEdits);
+    g_trackEdited = false;
+  }
+
+  simTrack.apply(edits);
+  if (!simTrack.update())
+    return;
+
+  ArcLengthTable const &arcLengthTable = simTrack.arcLengthTable();
+  g_coaster.updateTrack(
+      arcLengthTable,
+      arcLengthTable.segmentStart(simTrack.updatedSegments().front()));
+  g_coaster.setParameters(defaultCoasterParameters(g_coaster));
 }
 
 void setupVAO() {
@@ -379,6 +579,17 @@ void setupVAO() {
                         (void *)0 // array buffer offset
                         );
 
+  // per car attributes, advance once per instance instead of per vertex
+  glBindBuffer(GL_ARRAY_BUFFER, instanceBufferID);
+  glEnableVertexAttribArray(1);
+  glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceTransform),
+                        (void *)offsetof(InstanceTransform, positionScale));
+  glVertexAttribDivisor(1, 1);
+  glEnableVertexAttribArray(2);
+  glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceTransform),
+                        (void *)offsetof(InstanceTransform, orientation));
+  glVertexAttribDivisor(2, 1);
+
   glBindVertexArray(line_vaoID);
 
   glEnableVertexAttribArray(0); // match layout # in shader
@@ -410,63 +621,133 @@ void reloadProjectionMatrix() {
 }
 
 void loadModelViewMatrix() {
-  M = mat4(1);
   line_M = mat4(1);
   // view doesn't change, but if it did you would use this
-  V = camera.lookatMatrix();
+  V = camera.viewMatrix();
 }
 
-void reloadViewMatrix() { V = camera.lookatMatrix(); }
+void reloadViewMatrix() { V = camera.viewMatrix(); }
+
+void setupModelTransforms() { modelMatrices[LINE_OBJECT] = line_M; }
 
-void setupModelViewProjectionTransform() {
-  MVP = P * V * M; // transforms vertices from right to left (odd huh?)
+void reloadModelUniform() {
+  uploadMatrixBuffer(GL_UNIFORM_BUFFER, modelBufferID, modelMatrices);
 }
 
-void reloadMVPUniform() {
-  GLint id = glGetUniformLocation(basicProgramID, "MVP");
+// Orphaned, written once per frame
+void reloadInstanceBuffer() {
+  TraceScope scope("reloadInstanceBuffer", "upload");
 
-  glUseProgram(basicProgramID);
-  glUniformMatrix4fv(id,        // ID
-                     1,         // only 1 matrix
-                     GL_TRUE,   // transpose matrix, Mat4f is row major
-                     &MVP[0][0] // pointer to data in Mat4f
-                     );
+  glBindBuffer(GL_ARRAY_BUFFER, instanceBufferID);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(InstanceTransform) * carInstances.size(),
+               NULL, GL_STREAM_DRAW);
+  glBufferSubData(GL_ARRAY_BUFFER, 0,
+                  sizeof(InstanceTransform) * carInstances.size(),
+                  carInstances.data());
 }
 
-void reloadColorUniform(float r, float g, float b) {
-  GLint id = glGetUniformLocation(basicProgramID, "inputColor");
+void reloadInstancedUniforms(float r, float g, float b) {
+  instancedProgram.setUniform(instanced_colorLocation, r, g, b);
+}
 
-  glUseProgram(basicProgramID);
-  glUniform3f(id, // ID in basic_vs.glsl
-              r, g, b);
+void reloadCameraBuffer() {
+  TraceScope scope("reloadCameraBuffer", "upload");
+
+  CameraMatrices matrices;
+  matrices.view = V;
+  matrices.projection = P;
+  matrices.viewProjection = P * V;
+
+  glBindBuffer(GL_UNIFORM_BUFFER, cameraBufferID);
+  glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(CameraMatrices), &matrices);
+}
+
+void reloadObjectIndexUniform(int index) {
+  basicProgram.setUniform(basic_objectIndexLocation, index);
+}
+
+// Writes only the matrices in use into the buffer allocated (MAX_OBJECTS
+// matrices) in generateIDs(). glm matrices are column major, no transpose
+// needed.
+void uploadMatrixBuffer(GLenum target, GLuint bufferID,
+                        vector<mat4> const &matrices) {
+  TraceScope scope("uploadMatrixBuffer", "upload");
+
+  glBindBuffer(target, bufferID);
+  glBufferSubData(target, 0, sizeof(mat4) * matrices.size(), matrices.data());
+}
+
+void reloadColorUniform(float r, float g, float b) {
+  basicProgram.setUniform(basic_colorLocation, // ID in basic_vs.glsl
+                          r, g, b);
 }
 
 void generateIDs() {
   // shader ID from OpenGL
   string vsSource = loadShaderStringfromFile("./shaders/basic_vs.glsl");
   string fsSource = loadShaderStringfromFile("./shaders/basic_fs.glsl");
-  basicProgramID = CreateShaderProgram(vsSource, fsSource);
+  basicProgram.adopt(
+      CreateCachedShaderProgram(vsSource, fsSource, SHADER_CACHE_DIR));
+  basicProgram.bindUniformBlock("ObjectTransforms", OBJECT_TRANSFORMS_BINDING);
+  basic_objectIndexLocation = basicProgram.uniformLocation("objectIndex");
+  basic_colorLocation = basicProgram.uniformLocation("inputColor");
+
+  string instancedVsSource =
+      loadShaderStringfromFile("./shaders/instanced_vs.glsl");
+  instancedProgram.adopt(
+      CreateCachedShaderProgram(instancedVsSource, fsSource, SHADER_CACHE_DIR));
+  instanced_colorLocation = instancedProgram.uniformLocation("inputColor");
 
   // VAO and buffer IDs given from OpenGL
   glGenVertexArrays(1, &vaoID);
   glGenBuffers(1, &vertBufferID);
+  glGenBuffers(1, &indexBufferID);
+  glGenBuffers(1, &instanceBufferID);
   glGenVertexArrays(1, &line_vaoID);
   glGenBuffers(1, &line_vertBufferID);
+
+  // the whole block (MAX_OBJECTS matrices) must be backed, even though only
+  // the objects in use are written each frame
+  glGenBuffers(1, &modelBufferID);
+  glBindBuffer(GL_UNIFORM_BUFFER, modelBufferID);
+  glBufferData(GL_UNIFORM_BUFFER, sizeof(mat4) * MAX_OBJECTS, NULL,
+               GL_DYNAMIC_DRAW);
+  glBindBufferBase(GL_UNIFORM_BUFFER, OBJECT_TRANSFORMS_BINDING,
+                   modelBufferID);
+
+  glGenBuffers(1, &cameraBufferID);
+  glBindBuffer(GL_UNIFORM_BUFFER, cameraBufferID);
+  glBufferData(GL_UNIFORM_BUFFER, sizeof(CameraMatrices), NULL,
+               GL_DYNAMIC_DRAW);
+  glBindBufferBase(GL_UNIFORM_BUFFER, CAMERA_MATRICES_BINDING, cameraBufferID);
 }
 
 void deleteIDs() {
-  glDeleteProgram(basicProgramID);
+  basicProgram.destroy();
+  instancedProgram.destroy();
 
   glDeleteVertexArrays(1, &vaoID);
   glDeleteBuffers(1, &vertBufferID);
+  glDeleteBuffers(1, &indexBufferID);
+  glDeleteBuffers(1, &instanceBufferID);
   glDeleteVertexArrays(1, &line_vaoID);
   glDeleteBuffers(1, &line_vertBufferID);
+  glDeleteBuffers(1, &modelBufferID);
+  glDeleteBuffers(1, &cameraBufferID);
+
+  g_gpuTimer.destroy();
 }
 
 void init() {
+  TraceScope scope("init", "startup");
+
   glEnable(GL_DEPTH_TEST);
   glPointSize(50);
 
+  // strip meshes separate their strips with this index
+  glEnable(GL_PRIMITIVE_RESTART);
+  glPrimitiveRestartIndex(MESH_RESTART_INDEX);
+
   camera = Camera(vec3(0, 0, 5), vec3(0, 0, -1), vec3(0, 1, 0));
 
   // SETUP SHADERS, BUFFERS, VAOs
@@ -478,20 +759,37 @@ void init() {
 
   loadModelViewMatrix();
   reloadProjectionMatrix();
-  setupModelViewProjectionTransform();
-  reloadMVPUniform();
+
+  setupCoaster();
+  animateBead(); // place the cars before the first frame
+  previousSimCars = simCars;
+  publishSnapshot(g_scheduler);
+  consumeSnapshot();
+
+  if (!g_headless.enabled)
+    startSimulation();
 }
 
 int main(int argc, char **argv) {
   GLFWwindow *window;
 
+  if (!parseArguments(argc, argv))
+    return 1;
+
+  setupTracing();
+  setupProfiler();
+
+  Tracer::global().begin("create window", "startup");
   if (!glfwInit()) {
     exit(EXIT_FAILURE);
   }
 
-  glfwWindowHint(GLFW_SAMPLES, 4);
+  // offscreen targets have their own samples
+  glfwWindowHint(GLFW_SAMPLES, g_headless.enabled ? 0 : 4);
+  if (g_headless.enabled)
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 2);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3); // 3.3 for instanced arrays
   glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
   glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
@@ -503,7 +801,7 @@ int main(int argc, char **argv) {
   }
 
   glfwMakeContextCurrent(window);
-  glfwSwapInterval(1);
+  glfwSwapInterval(g_headless.enabled ? 0 : 1); // as fast as it renders
 
   glfwSetWindowSizeCallback(window, windowSetSizeFunc);
   glfwSetFramebufferSizeCallback(window, windowSetFramebufferSizeFunc);
@@ -511,42 +809,175 @@ int main(int argc, char **argv) {
   glfwSetCursorPosCallback(window, windowMouseMotionFunc);
   glfwSetMouseButtonCallback(window, windowMouseButtonFunc);
 
-  glfwGetFramebufferSize(window, &WIN_WIDTH, &WIN_HEIGHT);
+  // headless frames are the size asked for, whatever the window got
+  if (!g_headless.enabled)
+    glfwGetFramebufferSize(window, &WIN_WIDTH, &WIN_HEIGHT);
 
   // Initialize glad
   if (!gladLoadGL()) {
     std::cerr << "Failed to initialise GLAD" << std::endl;
     return -1;
   }
+  Tracer::global().end("create window", "startup");
 
   std::cout << "GL Version: :" << glGetString(GL_VERSION) << std::endl;
+
+  if (!loadProgramBinaryFunctions((GLADloadproc)glfwGetProcAddress))
+    std::cout << "Program binaries not supported, shader cache disabled"
+              << std::endl;
   std::cout << GL_ERROR() << std::endl;
 
   // Initialize all the geometry, and load it once to the GPU
   init(); // our own initialize stuff func
 
-  float t = 0;
-  float dt = 0.01;
+  if (g_headless.enabled)
+    runHeadless();
+  else
+    runWindowed(window);
+
+  // clean up after loop
+  g_simulationThread.stop();
+  deleteIDs();
+
+  if (g_profileReportSeconds > 0.0)
+    g_profiler.report(cout);
+  g_profiler.closeCsv();
+  writeTrace();
+
+  return 0;
+}
+
+void runWindowed(GLFWwindow *window) {
+  double lastFrameTime = glfwGetTime();
+  double lastReportTime = lastFrameTime;
 
   while (glfwGetKey(window, GLFW_KEY_ESCAPE) != GLFW_PRESS &&
          !glfwWindowShouldClose(window)) {
+    g_profiler.nextFrame();
+    g_gpuTimer.beginFrame();
+    ProfileScope frameScope(g_profiler, PROFILE_FRAME);
+    TraceScope frameTrace("frame", "frame");
 
-    if (g_play) {
-      t += dt;
-      animateBead(t);
-    }
+    double now = glfwGetTime();
+    float frameSeconds = float(now - lastFrameTime);
+    lastFrameTime = now;
+
+    consumeSnapshot();
+    uploadTrackEdits();
+    updateRideCamera(frameSeconds);
 
     displayFunc();
     moveCamera();
 
-    glfwSwapBuffers(window);
+    {
+      ProfileScope scope(g_profiler, PROFILE_SWAP);
+      TraceScope trace("glfwSwapBuffers", "frame");
+      glfwSwapBuffers(window);
+    }
     glfwPollEvents();
+
+    reportProfile(now, lastReportTime);
+  }
+}
+
+// g_headless.frames frames, 1/fps of simulated time apart, as fast as they
+// can be drawn and written
+void runHeadless() {
+  OffscreenTarget target;
+  FrameReadback readback;
+  if (!target.create(WIN_WIDTH, WIN_HEIGHT, g_headless.samples) ||
+      !readback.create(WIN_WIDTH, WIN_HEIGHT)) {
+    std::cerr << "Cannot create a " << WIN_WIDTH << "x" << WIN_HEIGHT
+              << " offscreen framebuffer" << std::endl;
+    return;
   }
 
-  // clean up after loop
-  deleteIDs();
+  mkdir(g_headless.outputDir.c_str(), 0755); // fails harmlessly if it exists
+  long long failed = 0;
+  FrameReadback::FrameSink writeFrame = [&](long long frame,
+                                            unsigned char const *rgb,
+                                            int width, int height) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "/frame_%06lld.ppm", frame);
+    if (!writePPM(g_headless.outputDir + name, rgb, width, height))
+      ++failed;
+  };
+
+  g_play = true;
+  if (g_headless.ride)
+    camera.startRide(0.f);
+
+  float frameSeconds = float(1.0 / g_headless.fps);
+  double start = glfwGetTime();
+  double lastReportTime = start;
+
+  for (int frame = 0; frame < g_headless.frames; ++frame) {
+    g_profiler.nextFrame();
+    g_gpuTimer.beginFrame();
+    ProfileScope frameScope(g_profiler, PROFILE_FRAME);
+    TraceScope frameTrace("frame", "frame");
+
+    consumeSnapshot();
+    updateRideCamera(frameSeconds);
+
+    target.bind();
+    displayFunc();
+    readback.capture(target, writeFrame);
 
-  return 0;
+    // the state of the next frame
+    if (g_scheduler.update(frameSeconds, stepSimulation) > 0)
+      publishSnapshot(g_scheduler);
+
+    reportProfile(glfwGetTime(), lastReportTime);
+  }
+  readback.finish(writeFrame);
+
+  double seconds = glfwGetTime() - start;
+  cout << readback.numCaptured() << " frames written to "
+       << g_headless.outputDir << " in " << seconds << " s ("
+       << readback.numCaptured() / std::max(seconds, 1e-9) << " frames/s, "
+       << readback.stalls() << " readback stalls";
+  if (failed > 0)
+    cout << ", " << failed << " could not be written";
+  cout << ")" << endl;
+}
+
+// [track] [--headless] [--frames n] [--fps f] [--size WxH] [--samples n]
+// [--ride] [--output dir]
+bool parseArguments(int argc, char **argv) {
+  for (int i = 1; i < argc; ++i) {
+    string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (arg == "--headless")
+      g_headless.enabled = true;
+    else if (arg == "--ride")
+      g_headless.ride = true;
+    else if (arg == "--frames" && hasValue)
+      g_headless.frames = std::max(0, std::atoi(argv[++i]));
+    else if (arg == "--fps" && hasValue)
+      g_headless.fps = std::max(std::atof(argv[++i]), 1e-3);
+    else if (arg == "--samples" && hasValue)
+      g_headless.samples = std::max(0, std::atoi(argv[++i]));
+    else if (arg == "--output" && hasValue)
+      g_headless.outputDir = argv[++i];
+    else if (arg == "--size" && hasValue &&
+             std::sscanf(argv[++i], "%dx%d", &WIN_WIDTH, &WIN_HEIGHT) == 2 &&
+             WIN_WIDTH > 0 && WIN_HEIGHT > 0)
+      continue;
+    else if (arg.compare(0, 2, "--") != 0 && g_trackFileName.empty())
+      g_trackFileName = arg;
+    else {
+      std::cerr << "Usage: " << argv[0]
+                << " [track] [--headless] [--frames n] [--fps f]"
+                   " [--size WxH] [--samples n] [--ride] [--output dir]"
+                << std::endl;
+      return false;
+    }
+  }
+
+  FB_WIDTH = WIN_WIDTH;
+  FB_HEIGHT = WIN_HEIGHT;
+  return true;
 }
 
 //==================== CALLBACK FUNCTIONS ====================//
@@ -556,8 +987,6 @@ void windowSetSizeFunc(GLFWwindow *window, int width, int height) {
   WIN_HEIGHT = height;
 
   reloadProjectionMatrix();
-  setupModelViewProjectionTransform();
-  reloadMVPUniform();
 }
 
 void windowSetFramebufferSizeFunc(GLFWwindow *window, int width, int height) {
@@ -575,6 +1004,8 @@ void windowMouseButtonFunc(GLFWwindow *window, int button, int action,
     } else {
       g_cursorLocked = GL_FALSE;
     }
+  } else if (button == GLFW_MOUSE_BUTTON_RIGHT) {
+    g_draggingPoint = (action == GLFW_PRESS);
   }
 }
 
@@ -585,10 +1016,11 @@ void windowMouseMotionFunc(GLFWwindow *window, double x, double y) {
     camera.rotateAroundFocus(deltaX, deltaY);
 
     reloadViewMatrix();
-    setupModelViewProjectionTransform();
-    reloadMVPUniform();
   }
 
+  if (g_draggingPoint)
+    dragControlPoint(x - g_cursorX, y - g_cursorY);
+
   g_cursorX = x;
   g_cursorY = y;
 }
@@ -638,6 +1070,40 @@ void windowKeyFunc(GLFWwindow *window, int key, int scancode, int action,
     break;
   case GLFW_KEY_SPACE:
     g_play = set ? !g_play : g_play;
+    g_simulationThread.setPaused(!g_play);
+    break;
+  case GLFW_KEY_MINUS:
+    if (action == GLFW_PRESS)
+      g_simulationThread.setTimeScale(g_simulationThread.timeScale() * 0.5);
+    break;
+  case GLFW_KEY_EQUAL:
+    if (action == GLFW_PRESS)
+      g_simulationThread.setTimeScale(g_simulationThread.timeScale() * 2.0);
+    break;
+  case GLFW_KEY_R:
+    if (action == GLFW_PRESS) {
+      g_ride = !g_ride;
+      if (g_ride)
+        camera.startRide(RIDE_BLEND_SECONDS);
+      else
+        camera.stopRide(RIDE_BLEND_SECONDS);
+    }
+    break;
+  case GLFW_KEY_P:
+    if (action == GLFW_PRESS) {
+      g_profileReportSeconds =
+          (g_profileReportSeconds > 0.0) ? 0.0 : DEFAULT_PROFILE_REPORT_SECONDS;
+      cout << "profile reports " << (g_profileReportSeconds > 0.0 ? "on" : "off")
+           << endl;
+    }
+    break;
+  case GLFW_KEY_COMMA:
+    if (action == GLFW_PRESS)
+      selectControlPoint(-1);
+    break;
+  case GLFW_KEY_PERIOD:
+    if (action == GLFW_PRESS)
+      selectControlPoint(1);
     break;
   case GLFW_KEY_LEFT_BRACKET:
     if (mods == GLFW_MOD_SHIFT) {
@@ -661,6 +1127,8 @@ void windowKeyFunc(GLFWwindow *window, int key, int scancode, int action,
 //==================== OPENGL HELPER FUNCTIONS ====================//
 
 void moveCamera() {
+  ProfileScope scope(g_profiler, PROFILE_MOVE_CAMERA);
+
   vec3 dir;
 
   if (g_moveBackForward) {
@@ -686,10 +1154,75 @@ void moveCamera() {
   if (g_moveUpDown || g_moveLeftRight || g_moveBackForward ||
       g_rotateLeftRight || g_rotateUpDown || g_rotateRoll) {
     camera.move(dir);
-    reloadViewMatrix();
-    setupModelViewProjectionTransform();
-    reloadMVPUniform();
+    reloadViewMatrix(); // uniforms are refreshed once per frame in displayFunc
+  }
+}
+
+// Puts the camera on the lead car, as drawn this frame, while riding or
+// blending in or out of the ride
+void updateRideCamera(float frameSeconds) {
+  bool wasRiding = camera.riding();
+  camera.update(frameSeconds);
+  if (!wasRiding && !camera.riding())
+    return;
+
+  if (!carInstances.empty()) {
+    InstanceTransform const &lead = carInstances.front();
+    camera.setRidePose(vec3(lead.positionScale), lead.orientation);
+  }
+  reloadViewMatrix();
+}
+
+// QUAD_ANIMATION_PROFILE=seconds prints a report that often,
+// QUAD_ANIMATION_PROFILE_CSV=file writes every timing to file
+void setupProfiler() {
+  char const *seconds = std::getenv("QUAD_ANIMATION_PROFILE");
+  if (seconds)
+    g_profileReportSeconds = std::max(std::atof(seconds), 0.0);
+
+  char const *csv = std::getenv("QUAD_ANIMATION_PROFILE_CSV");
+  if (csv && *csv && !g_profiler.openCsv(csv))
+    cout << "Could not open profile CSV file: " << csv << endl;
+}
+
+// QUAD_ANIMATION_TRACE=file records a trace from here on, written to file
+// by writeTrace() at exit
+void setupTracing() {
+  char const *fileName = std::getenv("QUAD_ANIMATION_TRACE");
+  if (!fileName || !*fileName)
+    return;
+
+  g_traceFileName = fileName;
+  Tracer::global().setThreadName("main");
+  Tracer::global().start();
+}
+
+void writeTrace() {
+  if (g_traceFileName.empty())
+    return;
+
+  Tracer::global().stop();
+  if (Tracer::global().writeJson(g_traceFileName))
+    cout << Tracer::global().numEvents() << " trace events written to "
+         << g_traceFileName << endl;
+  else
+    cout << "Could not write trace file: " << g_traceFileName << endl;
+}
+
+// Every g_profileReportSeconds, the GPU timings dropped so far included
+void reportProfile(double now, double &lastReport) {
+  if (g_profileReportSeconds <= 0.0) {
+    lastReport = now;
+    return;
   }
+  if (now - lastReport < g_profileReportSeconds)
+    return;
+
+  lastReport = now;
+  g_profiler.report(cout);
+  if (g_gpuTimer.dropped() > 0)
+    cout << g_gpuTimer.dropped() << " GPU timings dropped (not ready in time)"
+         << endl;
 }
 
 std::string GL_ERROR() {
@@ -0,0 +1,133 @@
+/**
+ * File:	CoasterSim.cpp
+ *
+ * Summary:
+ *
+ * Headless counterpart of QuadAnimation: runs the same pipeline without a
+ * window or GL context (track loading, curve tessellation, arc length table,
+ * track frames, bead mesh generation, the coaster simulation and placing
+ * the trains) and reports how long each stage takes. Links only the core
+ * library, so it builds and runs on machines without a display.
+ *
+ * Usage: ./CoasterSim [track] [numTrains] [simulatedSeconds]
+ *
+ * track is a text or .trk file, "-" (or nothing) for the built in track.
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "ArcLengthTable.h"
+#include "CoasterPhysics.h"
+#include "CurveTessellator.h"
+#include "MeshGenerator.h"
+#include "RotationMinimizingFrames.h"
+#include "TrackFile.h"
+
+typedef std::chrono::high_resolution_clock Clock;
+
+double millisecondsSince(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start)
+      .count();
+}
+
+int main(int argc, char **argv) {
+  std::string trackFileName = (argc > 1) ? argv[1] : "-";
+  int numTrains = (argc > 2) ? std::atoi(argv[2]) : 1024;
+  float seconds = (argc > 3) ? float(std::atof(argv[3])) : 60.f;
+  const float dt = 1.f / 1000.f; // same rate as the viewer
+
+  // ===== TRACK ===== //
+  std::vector<glm::vec3> controlPoints;
+  ArcLengthTable arcLengthTable;
+
+  Clock::time_point start = Clock::now();
+  if (trackFileName == "-") {
+    controlPoints = defaultTrackControlPoints();
+    arcLengthTable.build(controlPoints);
+  } else {
+    std::string error;
+    bool loaded =
+        loadTrack(trackFileName, controlPoints, arcLengthTable, &error);
+    if (!error.empty())
+      std::cerr << error << std::endl;
+    if (!loaded)
+      return 1;
+  }
+  double trackTime = millisecondsSince(start);
+
+  // ===== CURVE ===== //
+  const int curveSamples = 16; // per segment, as the viewer draws the track
+  std::vector<glm::vec3> curve;
+  start = Clock::now();
+  tessellateCurve(controlPoints, curveSamples, curve);
+  double curveTime = millisecondsSince(start);
+
+  // ===== FRAMES ===== //
+  RotationMinimizingFrames frames;
+  start = Clock::now();
+  frames.build(arcLengthTable);
+  double framesTime = millisecondsSince(start);
+
+  // ===== BEAD MESH ===== //
+  IndexedMesh sphere;
+  start = Clock::now();
+  getSpherePoints(0.3f, glm::vec3(0, 0, 0), sphere, MESH_TRIANGLE_STRIPS);
+  double meshTime = millisecondsSince(start);
+
+  // ===== PHYSICS ===== //
+  CoasterSimulation sim;
+  sim.setTrack(arcLengthTable);
+  CoasterParameters parameters = defaultCoasterParameters(sim);
+  sim.setParameters(parameters);
+
+  float length = sim.trackLength();
+  for (int i = 0; i < numTrains; ++i)
+    sim.addTrain(i * length / numTrains, parameters.chainSpeed);
+
+  long long numSteps = static_cast<long long>(seconds / dt);
+  start = Clock::now();
+  for (long long i = 0; i < numSteps; ++i)
+    sim.step(dt);
+  double simTime = millisecondsSince(start);
+
+  long long rides = 0;
+  for (int i = 0; i < numTrains; ++i)
+    rides += sim.laps(i);
+
+  // position and orientation of every train, as drawing them needs
+  std::vector<glm::vec3> positions(numTrains);
+  std::vector<Quat4f> orientations(numTrains);
+  start = Clock::now();
+  for (int i = 0; i < numTrains; ++i) {
+    float s = sim.distance(i);
+    ArcLengthCursor cursor;
+    ArcLengthSample sample = arcLengthTable.sampleAt(s, cursor);
+    positions[i] = arcLengthTable.positionAt(s, cursor);
+    orientations[i] = frames.orientationAt(sample);
+  }
+  double placeTime = millisecondsSince(start);
+
+  std::cout << "track      : " << controlPoints.size() << " control points, "
+            << length << " m, " << trackTime << " ms" << std::endl;
+  std::cout << "curve      : " << curve.size() << " vertices, "
+            << curveTime << " ms" << std::endl;
+  std::cout << "frames     : " << frames.size() << " samples, twist "
+            << frames.closingTwist() << ", " << framesTime << " ms"
+            << std::endl;
+  std::cout << "bead mesh  : " << sphere.vertices.size() << " vertices, "
+            << sphere.indices.size() << " indices, " << meshTime << " ms"
+            << std::endl;
+  std::cout << "simulation : " << numTrains << " trains, " << seconds
+            << " s at " << 1.f / dt << " Hz, " << simTime << " ms, "
+            << rides / (simTime / 1000.0) << " rides/s" << std::endl;
+  std::cout << "placing    : " << numTrains << " trains, " << placeTime
+            << " ms" << std::endl;
+
+  return 0;
+}
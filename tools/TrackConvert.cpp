@@ -0,0 +1,72 @@
+/**
+ * File:	TrackConvert.cpp
+ *
+ * Summary:
+ *
+ * Converts a text control point file (one "x y z" per line, see
+ * Vec3f_FileIO.h) into the binary track format of TrackFile.h, then maps the
+ * result back and reports how long both loads take.
+ *
+ * Usage: ./TrackConvert input.txt output.trk [samplesPerSegment]
+ *
+ * samplesPerSegment defaults to ArcLengthTable::DEFAULT_SAMPLES_PER_SEGMENT,
+ * pass 0 to leave the arc length table out of the file.
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "ArcLengthTable.h"
+#include "TrackFile.h"
+#include "Vec3f_FileIO.h"
+
+typedef std::chrono::high_resolution_clock Clock;
+
+double millisecondsSince(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start)
+      .count();
+}
+
+int main(int argc, char **argv) {
+  if (argc < 3) {
+    std::cerr << "Usage: " << argv[0]
+              << " input.txt output.trk [samplesPerSegment]" << std::endl;
+    return 1;
+  }
+
+  std::string input = argv[1];
+  std::string output = argv[2];
+  int samplesPerSegment = (argc > 3)
+                              ? std::atoi(argv[3])
+                              : int(ArcLengthTable::DEFAULT_SAMPLES_PER_SEGMENT);
+
+  std::string error;
+  if (!convertTextTrackFile(input, output, samplesPerSegment, &error)) {
+    std::cerr << error << std::endl;
+    return 1;
+  }
+
+  Clock::time_point start = Clock::now();
+  VectorContainerVec3f vecs;
+  loadVec3fFromFile(vecs, input);
+  double textTime = millisecondsSince(start);
+
+  start = Clock::now();
+  MappedTrackFile track;
+  if (!track.open(output)) {
+    std::cerr << track.error() << std::endl;
+    return 1;
+  }
+  double mapTime = millisecondsSince(start);
+
+  std::cout << output << ": " << track.numPoints() << " points, "
+            << track.numArcLengths() << " arc length samples ("
+            << track.arcLengthSamplesPerSegment() << " per segment)"
+            << std::endl;
+  std::cout << "text load  : " << textTime << " ms" << std::endl;
+  std::cout << "binary map : " << mapTime << " ms" << std::endl;
+
+  return 0;
+}